@@ -1,125 +1,675 @@
 #include "AsyncLogging.h"
+#include "CurrentThread.h"
+#include "MonoTimestamp.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
+
+namespace
+{
+std::atomic<uint64_t> g_nextId(1);
+
+const size_t kDefaultBufferLimit = 64 * 1024 * 1024;
+const size_t kDefaultTotalBufferLimit = 256 * 1024 * 1024;
+
+// 块中每条日志的头部，后面紧跟len字节的日志内容
+struct RecordHeader
+{
+    int64_t time; // 单调时钟微秒数，后端按它归并各线程的日志
+    uint32_t len;
+};
+} // namespace
+
+struct AsyncLogging::Chunk : noncopyable
+{
+    Chunk() : committed(0), next(nullptr) {}
+
+    std::atomic<size_t> committed; // 已经提交的字节数，只有生产者写
+    std::atomic<Chunk *> next;     // 生产者写满本块后链接下一块
+    char data[kChunkSize];
+};
+
+/**
+ * 一个线程的日志缓冲链：first_ -> ... -> head_ -> ... -> tail_
+ * 生产者只写tail_，后端从head_读，head_之前的块后端已经写完，生产者换块时优先复用它们，
+ * 稳定运行时不分配内存（无界SPSC队列的节点缓存，和MpscQueue一样来自Vyukov）
+ * 只剩一块并且后端已经读完时原地重用这一块，分不到第二块的线程也能继续写。
+ * 块数达到上限时按OverflowPolicy处理；kDropOldest从链中摘下后端还没有开始读的最早一块。
+ * 换块、摘块、原地重用、collect/commit和释放写完的块用scanMutex_互斥（都不在快路径上），
+ * 因此后端和分不到块的线程都可以把别的线程用不着的块还给总上限
+ */
+class AsyncLogging::Producer : noncopyable
+{
+public:
+    enum AppendResult
+    {
+        kAppended,
+        kSwitched, // 换了新块，需要唤醒后端
+        kFull,     // 块数达到上限，没有写入
+    };
+
+    Producer(AsyncLogging &owner, size_t maxChunks, OverflowPolicy policy)
+        : owner_(owner), maxChunks_(maxChunks), policy_(policy), chunks_(1), tid_(CurrentThread::tid()),
+          tail_(new Chunk), first_(tail_), head_(tail_), readPos_(0), scanChunk_(tail_),
+          scanPos_(0), idle_(false), lastActive_(0), closed_(false), droppedMessages_(0), droppedBytes_(0),
+          reportedMessages_(0), reportedBytes_(0)
+    {
+        owner_.chunkAllocations_.fetch_add(1, std::memory_order_relaxed);
+        owner_.totalChunks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~Producer()
+    {
+        Chunk *chunk = first_;
+        while (chunk != nullptr)
+        {
+            Chunk *next = chunk->next.load(std::memory_order_relaxed);
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+    OverflowPolicy policy() const { return policy_; }
+    // 当前占用的块数
+    size_t chunks() const { return chunks_.load(std::memory_order_relaxed); }
+
+    // 以下由生产者线程调用
+    AppendResult append(int64_t time, const char *data, uint32_t len)
+    {
+        const size_t need = sizeof(RecordHeader) + len;
+        Chunk *chunk = tail_;
+        size_t pos = chunk->committed.load(std::memory_order_relaxed);
+        AppendResult result = kAppended;
+        if (pos + need > kChunkSize)
+        {
+            Chunk *next = allocChunk();
+            if (next == nullptr)
+                return kFull;
+            // 本块的committed已经是最终值，后端读到next之后不会再漏掉本块的日志
+            if (next != chunk)
+                chunk->next.store(next, std::memory_order_release);
+            tail_ = chunk = next;
+            pos = 0;
+            result = kSwitched;
+        }
+        RecordHeader header = {time, len};
+        memcpy(chunk->data + pos, &header, sizeof header);
+        memcpy(chunk->data + pos + sizeof header, data, len);
+        chunk->committed.store(pos + need, std::memory_order_release);
+        return result;
+    }
+
+    // 现在换块能不能拿到块（不算kDropOldest摘块）：有后端写完的块可以复用、唯一的一块已经读完，
+    // 或者没有达到块数上限
+    bool hasSpace() const
+    {
+        {
+            std::lock_guard<std::mutex> lock(scanMutex_);
+            if (first_ != head_.load(std::memory_order_relaxed) || drainedInLock())
+                return true;
+        }
+        return (maxChunks_ == 0 || chunks() < maxChunks_) && owner_.hasBudget();
+    }
+
+    void drop(uint64_t messages, uint64_t bytes)
+    {
+        droppedMessages_.fetch_add(messages, std::memory_order_relaxed);
+        droppedBytes_.fetch_add(bytes, std::memory_order_relaxed);
+        owner_.droppedMessages_.fetch_add(messages, std::memory_order_relaxed);
+        owner_.droppedBytes_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    // 以下由后端线程调用
+    // 把已经提交的日志追加到records，内容留在块中，写完之后调用commit才释放。
+    // maxChunks不为0时最多前进maxChunks块，留下的块kDropOldest可以丢弃，返回true表示还有日志没有取
+    bool collect(std::vector<Record> *records, size_t maxChunks)
+    {
+        std::lock_guard<std::mutex> lock(scanMutex_);
+        Chunk *chunk = head_.load(std::memory_order_relaxed);
+        size_t pos = readPos_;
+        const size_t count = records->size();
+        bool more = false;
+        for (size_t moved = 0;;)
+        {
+            // 先读next再读committed：next不为空时本块已经写完，读到的committed是最终值
+            Chunk *next = chunk->next.load(std::memory_order_acquire);
+            size_t end = chunk->committed.load(std::memory_order_acquire);
+            while (pos < end)
+            {
+                RecordHeader header;
+                memcpy(&header, chunk->data + pos, sizeof header);
+                records->push_back(Record{header.time, chunk->data + pos + sizeof header, header.len});
+                pos += sizeof header + header.len;
+            }
+            if (next == nullptr)
+                break;
+            if (maxChunks != 0 && ++moved > maxChunks)
+            {
+                more = true;
+                break;
+            }
+            chunk = next;
+            pos = 0;
+        }
+        scanChunk_ = chunk;
+        scanPos_ = pos;
+        idle_ = records->size() == count;
+        return more;
+    }
+
+    void commit()
+    {
+        std::lock_guard<std::mutex> lock(scanMutex_);
+        readPos_ = scanPos_;
+        head_.store(scanChunk_, std::memory_order_release);
+    }
+
+    // commit之后调用：force为false时只释放超过idleMicros没有写日志的线程写完的块，还在写的线程留着它们复用
+    size_t releaseIdle(bool force, int64_t now, int64_t idleMicros)
+    {
+        if (!idle_)
+            lastActive_ = now;
+        if (!force && now - lastActive_ < idleMicros)
+            return 0;
+        return releaseFree();
+    }
+
+    // 任意线程调用：释放后端已经写完的块（tail_总是留着），返回释放的块数，由调用者还给总上限
+    size_t releaseFree()
+    {
+        size_t released = 0;
+        std::lock_guard<std::mutex> lock(scanMutex_);
+        Chunk *head = head_.load(std::memory_order_relaxed);
+        while (first_ != head)
+        {
+            Chunk *chunk = first_;
+            first_ = chunk->next.load(std::memory_order_relaxed);
+            delete chunk;
+            ++released;
+        }
+        chunks_.fetch_sub(released, std::memory_order_relaxed);
+        return released;
+    }
+
+    // 上次调用以来丢弃的条数和字节数，没有丢弃时返回false
+    bool takeDropped(uint64_t *messages, uint64_t *bytes)
+    {
+        uint64_t totalMessages = droppedMessages_.load(std::memory_order_relaxed);
+        uint64_t totalBytes = droppedBytes_.load(std::memory_order_relaxed);
+        *messages = totalMessages - reportedMessages_;
+        *bytes = totalBytes - reportedBytes_;
+        reportedMessages_ = totalMessages;
+        reportedBytes_ = totalBytes;
+        return *messages > 0;
+    }
+
+    int tid() const { return tid_; }
+
+    // 线程已经退出，并且日志和丢弃说明都写完了
+    bool finished() const
+    {
+        if (!closed_.load(std::memory_order_acquire))
+            return false;
+        Chunk *chunk = head_.load(std::memory_order_relaxed);
+        return chunk->next.load(std::memory_order_acquire) == nullptr &&
+               chunk->committed.load(std::memory_order_acquire) == readPos_ &&
+               droppedMessages_.load(std::memory_order_relaxed) == reportedMessages_;
+    }
+
+    void close() { closed_.store(true, std::memory_order_release); }
+
+private:
+    // 返回tail_本身表示原地重用
+    Chunk *allocChunk()
+    {
+        {
+            std::lock_guard<std::mutex> lock(scanMutex_);
+            if (first_ != head_.load(std::memory_order_relaxed))
+            {
+                Chunk *chunk = first_;
+                first_ = chunk->next.load(std::memory_order_relaxed);
+                chunk->committed.store(0, std::memory_order_relaxed);
+                chunk->next.store(nullptr, std::memory_order_relaxed);
+                return chunk;
+            }
+            if (drainedInLock())
+            {
+                // 后端的读位置一起归零，collect在锁内读committed，不会读到新旧混杂的位置
+                tail_->committed.store(0, std::memory_order_relaxed);
+                readPos_ = 0;
+                scanPos_ = 0;
+                return tail_;
+            }
+        }
+        if ((maxChunks_ == 0 || chunks() < maxChunks_) && owner_.reserveChunk())
+        {
+            chunks_.fetch_add(1, std::memory_order_relaxed);
+            owner_.chunkAllocations_.fetch_add(1, std::memory_order_relaxed);
+            return new Chunk;
+        }
+        return policy_ == kDropOldest ? stealOldest() : nullptr;
+    }
+
+    // 链上只有tail_一块，后端已经读完并且commit（没有还在引用块内容的Record）
+    bool drainedInLock() const
+    {
+        return first_ == tail_ && head_.load(std::memory_order_relaxed) == tail_ && scanChunk_ == tail_ &&
+               scanPos_ == readPos_ && readPos_ == tail_->committed.load(std::memory_order_relaxed);
+    }
+
+    // 摘下后端还没有开始读的最早一块（scanChunk_之后、tail_之前），其中的日志计为丢弃
+    Chunk *stealOldest()
+    {
+        std::lock_guard<std::mutex> lock(scanMutex_);
+        Chunk *victim = scanChunk_->next.load(std::memory_order_relaxed);
+        if (victim == nullptr || victim == tail_)
+            return nullptr;
+        scanChunk_->next.store(victim->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        size_t end = victim->committed.load(std::memory_order_relaxed);
+        uint64_t messages = 0;
+        uint64_t bytes = 0;
+        for (size_t pos = 0; pos < end; ++messages)
+        {
+            RecordHeader header;
+            memcpy(&header, victim->data + pos, sizeof header);
+            bytes += header.len;
+            pos += sizeof header + header.len;
+        }
+        drop(messages, bytes);
+
+        victim->committed.store(0, std::memory_order_relaxed);
+        victim->next.store(nullptr, std::memory_order_relaxed);
+        return victim;
+    }
+
+    AsyncLogging &owner_;
+    const size_t maxChunks_;
+    const OverflowPolicy policy_;
+    std::atomic<size_t> chunks_; // 占用的块数，后端释放空闲的块时减少
+    const int tid_;
+    // 生产者使用
+    Chunk *tail_;
+    Chunk *first_; // 最早的块，到head_为止都可以复用，后端也会从这里释放（scanMutex_保护）
+    // 后端使用
+    std::atomic<Chunk *> head_;
+    size_t readPos_; // 原地重用时由生产者归零（scanMutex_保护）
+    mutable std::mutex scanMutex_;
+    Chunk *scanChunk_; // collect读到的位置，commit时发布
+    size_t scanPos_;
+    bool idle_;          // 上一次collect没有取到日志
+    int64_t lastActive_; // 最近一次取到日志的时间
+    std::atomic<bool> closed_;
+    // 生产者累加，后端取走差值写一行说明
+    std::atomic<uint64_t> droppedMessages_;
+    std::atomic<uint64_t> droppedBytes_;
+    uint64_t reportedMessages_;
+    uint64_t reportedBytes_;
+};
 
 AsyncLogging::AsyncLogging(const std::string &basename, off_t rollSize, int flushInterval)
     : flushInterval_(flushInterval),
       running_(false),
       basename_(basename),
       rollSize_(rollSize),
+      id_(g_nextId.fetch_add(1, std::memory_order_relaxed)),
       thread_(std::bind(&AsyncLogging::threadFunc, this), "Logging"),
-      currentBuffer_(new LargeBuffer)
+      maxChunks_(0),
+      policy_(kDropOldest),
+      maxTotalChunks_(0),
+      totalChunks_(0),
+      reclaimRequested_(false),
+      pending_(false),
+      droppedMessages_(0),
+      droppedBytes_(0),
+      chunkAllocations_(0),
+      producerBlocks_(0),
+      writes_(0),
+      writeMicros_(0),
+      maxWriteMicros_(0),
+      outputBuffer_(new LargeBuffer)
 {
-    currentBuffer_->bzero();
+    records_.reserve(4096);
+    setBufferLimit(kDefaultBufferLimit);
+    setTotalBufferLimit(kDefaultTotalBufferLimit);
+}
+
+void AsyncLogging::setBufferLimit(size_t bytes, OverflowPolicy policy)
+{
+    maxChunks_ = bytes == 0 ? 0 : std::max<size_t>(2, (bytes + kChunkSize - 1) / kChunkSize);
+    policy_ = policy;
+}
+
+void AsyncLogging::setTotalBufferLimit(size_t bytes)
+{
+    maxTotalChunks_ = (bytes + kChunkSize - 1) / kChunkSize;
+}
 
-    // 前端备用池只保留 frontBuffers（2）张
-    freeBuffers_.reserve(frontBuffers);
-    for (int i = 0; i < frontBuffers; ++i)
+bool AsyncLogging::reserveChunk()
+{
+    size_t n = totalChunks_.load(std::memory_order_relaxed);
+    for (;;)
     {
-        BufferPtr buffer_temp(new LargeBuffer);
-        buffer_temp->bzero();
-        freeBuffers_.push_back(std::move(buffer_temp));
+        if (maxTotalChunks_ != 0 && n >= maxTotalChunks_)
+        {
+            // 后端处理之前只做一次：先把各线程已经写完的块还给总上限，再请后端回收之后写完的块
+            if (reclaimRequested_.exchange(true, std::memory_order_relaxed))
+                return false;
+            size_t released = releaseFreeChunks();
+            notifyBackend();
+            if (released == 0)
+                return false;
+            n = totalChunks_.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (totalChunks_.compare_exchange_weak(n, n + 1, std::memory_order_relaxed))
+            return true;
     }
-
-    buffers_.reserve(16);
 }
 
-void AsyncLogging::append(const char *logline, int len)
+size_t AsyncLogging::releaseFreeChunks()
 {
+    size_t released = 0;
     std::lock_guard<std::mutex> lock(mutex_);
-    // currentBuffer_ 有足够空间
-    if (currentBuffer_->avail() > static_cast<size_t>(len))
+    for (const ProducerPtr &producer : producers_)
+        released += producer->releaseFree();
+    totalChunks_.fetch_sub(released, std::memory_order_relaxed);
+    return released;
+}
+
+bool AsyncLogging::hasBudget() const
+{
+    return maxTotalChunks_ == 0 || totalChunks_.load(std::memory_order_relaxed) < maxTotalChunks_;
+}
+
+AsyncLogging::Stats AsyncLogging::stats() const
+{
+    Stats s;
+    s.droppedMessages = droppedMessages_.load(std::memory_order_relaxed);
+    s.droppedBytes = droppedBytes_.load(std::memory_order_relaxed);
+    s.chunkAllocations = chunkAllocations_.load(std::memory_order_relaxed);
+    s.bufferChunks = totalChunks_.load(std::memory_order_relaxed);
+    s.producerBlocks = producerBlocks_.load(std::memory_order_relaxed);
+    s.writes = writes_.load(std::memory_order_relaxed);
+    s.writeMicros = writeMicros_.load(std::memory_order_relaxed);
+    s.maxWriteMicros = maxWriteMicros_.load(std::memory_order_relaxed);
+    return s;
+}
+
+AsyncLogging::Producer *AsyncLogging::localProducer()
+{
+    // 每个线程缓存最近写过的几个AsyncLogging的缓冲链，最近使用的在前面；
+    // 线程退出或者被挤出缓存时关闭缓冲链，后端写完剩下的日志后释放
+    struct Cache
     {
-        currentBuffer_->append(logline, len);
+        struct Entry
+        {
+            uint64_t owner = 0;
+            ProducerPtr producer;
+        };
+        Entry entries[kProducerCacheSize];
+        ~Cache()
+        {
+            for (Entry &entry : entries)
+            {
+                if (entry.producer)
+                    entry.producer->close();
+            }
+        }
+    };
+    thread_local Cache cache;
+    Cache::Entry *entries = cache.entries;
+    if (entries[0].owner == id_)
+        return entries[0].producer.get();
+
+    size_t i = 1;
+    while (i < kProducerCacheSize && entries[i].owner != id_)
+        ++i;
+    Cache::Entry entry;
+    if (i < kProducerCacheSize)
+    {
+        entry = std::move(entries[i]);
     }
     else
     {
-        // currentBuffer_ 写满了
-        buffers_.push_back(std::move(currentBuffer_));
-        // 先尝试从前端备用 freeBuffers_ 拿一张
-        if (!freeBuffers_.empty())
-        {
-            currentBuffer_ = std::move(freeBuffers_.back());
-            freeBuffers_.pop_back();
-        }
-        else
+        // 不在缓存中：挤掉最久没有用的一个
+        i = kProducerCacheSize - 1;
+        if (entries[i].producer)
+            entries[i].producer->close();
+        entry.owner = id_;
+        entry.producer = registerProducer();
+    }
+    std::move_backward(entries, entries + i, entries + i + 1);
+    entries[0] = std::move(entry);
+    return entries[0].producer.get();
+}
+
+AsyncLogging::ProducerPtr AsyncLogging::registerProducer()
+{
+    ProducerPtr producer = std::make_shared<Producer>(*this, maxChunks_, policy_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    producers_.push_back(producer);
+    return producer;
+}
+
+void AsyncLogging::notifyBackend()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = true;
+    }
+    cond_.notify_one();
+}
+
+void AsyncLogging::append(const char *logline, int len)
+{
+    if (len <= 0)
+        return;
+    size_t maxLen = kChunkSize - sizeof(RecordHeader);
+    if (static_cast<size_t>(len) > maxLen)
+        len = static_cast<int>(maxLen);
+    Producer *producer = localProducer();
+    int64_t now = MonoTimestamp::now().microSeconds();
+    for (;;)
+    {
+        switch (producer->append(now, logline, static_cast<uint32_t>(len)))
         {
-            // 没有备用时就 new 一张
-            currentBuffer_.reset(new LargeBuffer);
+        case Producer::kAppended:
+            // 等待后端定时来取
+            return;
+        case Producer::kSwitched:
+            // 写满了一个块，唤醒后端
+            notifyBackend();
+            return;
+        case Producer::kFull:
+            if (!handleFull(producer, static_cast<uint32_t>(len)))
+                return;
+            break;
         }
-        currentBuffer_->bzero();
-        currentBuffer_->append(logline, len);
+    }
+}
+
+bool AsyncLogging::handleFull(Producer *producer, uint32_t len)
+{
+    // 只有一块时等后端读完这一块原地重用；总上限满了时也可能等到后端回收别的线程空闲的块
+    if (producer->policy() == kBlockProducer && running_)
+    {
+        producerBlocks_.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(mutex_);
+        pending_ = true;
         cond_.notify_one();
+        // 后端commit/回收之后要先拿一次mutex_再通知，这里检查条件和等待之间不会漏掉通知
+        spaceCond_.wait(lock, [this, producer] { return producer->hasSpace() || !running_; });
+        return true;
     }
+    // 换块时已经唤醒过后端，这里只计数
+    producer->drop(1, len);
+    return false;
 }
 
 void AsyncLogging::threadFunc()
 {
     LogFile output(basename_, rollSize_);
-
-    // 后端“待写池”
-    BufferVector buffersToWrite;
-    buffersToWrite.reserve(16);
-
-    // ——下面是后端每轮要预先分配的 backBuffers+1 张空缓冲
-    BufferVector newbufferVec;
-    newbufferVec.reserve(backBuffers + 1);
-    for (int i = 0; i < backBuffers + 1; ++i)
-    {
-        BufferPtr buf(new LargeBuffer);
-        buf->bzero();
-        newbufferVec.push_back(std::move(buf));
-    }
+    if (fileHeader_)
+        output.setFileHeader(fileHeader_);
+    std::vector<ProducerPtr> producers;
+    bool more = false;
 
     while (running_)
     {
         {
             std::unique_lock<std::mutex> lock(mutex_);
-            if (buffers_.empty())
+            // 上一轮因为块数限制没有取完时不等待
+            if (!pending_ && !more)
             {
                 cond_.wait_for(lock, std::chrono::seconds(flushInterval_));
             }
-            // 无论超时还是被唤醒，都把 currentBuffer_ “强制” 移交给待写队列
-            buffers_.push_back(std::move(currentBuffer_));
-
-            // 1) 从 newbufferVec 弹出一张给前端新的 currentBuffer_
-            currentBuffer_ = std::move(newbufferVec.back());
-            newbufferVec.pop_back();
-
-            // 2) 把 newbufferVec 里多余的缓冲补充给前端备用 freeBuffers_
-            //    直到 freeBuffers_.size() == frontBuffers（2 张）
-            while (freeBuffers_.size() < static_cast<size_t>(frontBuffers))
-            {
-                freeBuffers_.push_back(std::move(newbufferVec.back()));
-                newbufferVec.pop_back();
-            }
-
-            // 3) 把 buffers_（前端写满的部分） swap 到 buffersToWrite
-            buffersToWrite.swap(buffers_);
+            pending_ = false;
+            producers = producers_;
         }
 
-        // 解锁后，实际把 buffersToWrite 里所有缓冲落盘
-        for (const auto &buffer : buffersToWrite)
+        more = drain(producers, output);
+
+        // 回收已经退出的线程的缓冲链
         {
-            output.append(buffer->data(), buffer->length());
+            std::lock_guard<std::mutex> lock(mutex_);
+            producers_.erase(std::remove_if(producers_.begin(), producers_.end(),
+                                            [this](const ProducerPtr &p) {
+                                                if (!p->finished())
+                                                    return false;
+                                                totalChunks_.fetch_sub(p->chunks(), std::memory_order_relaxed);
+                                                return true;
+                                            }),
+                             producers_.end());
         }
+        producers.clear();
 
-        // 如果积压的缓冲超过 backBuffers+1（7 张），就丢弃多余的
-        if (buffersToWrite.size() > static_cast<size_t>(backBuffers + 1))
+        flushOutput(output);
+    }
+    // 线程退出前把剩下的日志写完
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        producers = producers_;
+    }
+    while (drain(producers, output))
+    {
+    }
+    flushOutput(output);
+}
+
+void AsyncLogging::writeOutput(LogFile &output, const char *data, size_t len)
+{
+    int64_t start = MonoTimestamp::now().microSeconds();
+    output.append(data, static_cast<int>(len));
+    recordWrite(MonoTimestamp::now().microSeconds() - start);
+}
+
+void AsyncLogging::flushOutput(LogFile &output)
+{
+    int64_t start = MonoTimestamp::now().microSeconds();
+    output.flush();
+    recordWrite(MonoTimestamp::now().microSeconds() - start);
+}
+
+void AsyncLogging::recordWrite(int64_t micros)
+{
+    // 只有后端线程写
+    uint64_t us = static_cast<uint64_t>(micros);
+    writes_.fetch_add(1, std::memory_order_relaxed);
+    writeMicros_.fetch_add(us, std::memory_order_relaxed);
+    if (us > maxWriteMicros_.load(std::memory_order_relaxed))
+        maxWriteMicros_.store(us, std::memory_order_relaxed);
+}
+
+bool AsyncLogging::drain(const std::vector<ProducerPtr> &producers, LogFile &output)
+{
+    // 有块数限制时每轮每个线程最多取一半，剩下的块kDropOldest可以丢弃，生产者不必丢弃新日志
+    const size_t maxChunks = maxChunks_ / 2;
+    bool more = false;
+
+    // 每个线程的日志在records_中是一段按时间有序的区间：[begin, end)
+    using Range = std::pair<size_t, size_t>;
+    std::vector<Range> ranges;
+    ranges.reserve(producers.size());
+    records_.clear();
+    for (const ProducerPtr &producer : producers)
+    {
+        size_t begin = records_.size();
+        more = producer->collect(&records_, maxChunks) || more;
+        if (records_.size() > begin)
+            ranges.emplace_back(begin, records_.size());
+
+        // 丢弃过日志的线程，在本轮的日志之前写一条说明
+        uint64_t messages, bytes;
+        if (producer->takeDropped(&messages, &bytes))
         {
-            buffersToWrite.resize(backBuffers + 1);
+            char buf[256];
+            int n = snprintf(buf, sizeof buf,
+                             "%s WARN  AsyncLogging dropped %" PRIu64 " messages (%" PRIu64
+                             " bytes) from thread %d, buffer limit reached\n",
+                             Timestamp::now().toFormattedString(true).c_str(), messages, bytes, producer->tid());
+            fputs(buf, stderr);
+            if (dropMarker_)
+            {
+                std::string marker = dropMarker_(messages, bytes, producer->tid());
+                outputBuffer_->append(marker.data(), marker.size());
+            }
+            else
+            {
+                outputBuffer_->append(buf, std::min<int>(n, static_cast<int>(sizeof buf) - 1));
+            }
         }
+    }
 
-        // 把用过的缓冲回收到 newbufferVec，保证 newbufferVec 恢复到 backBuffers+1 张
-        while (newbufferVec.size() < static_cast<size_t>(backBuffers + 1))
+    auto write = [this, &output](const Record &record) {
+        if (outputBuffer_->avail() <= record.len)
         {
-            newbufferVec.push_back(std::move(buffersToWrite.back()));
-            buffersToWrite.pop_back();
-            newbufferVec.back()->reset(); // 清空缓冲
+            writeOutput(output, outputBuffer_->data(), outputBuffer_->length());
+            outputBuffer_->reset();
         }
-        buffersToWrite.clear();
+        outputBuffer_->append(record.data, record.len);
+    };
 
-        output.flush();
+    // 多路归并：每次取各区间开头时间最早的一条，时间相同时先写前面注册的线程
+    auto later = [this](const Range &lhs, const Range &rhs) {
+        const Record &l = records_[lhs.first];
+        const Record &r = records_[rhs.first];
+        return l.time != r.time ? l.time > r.time : lhs.first > rhs.first;
+    };
+    std::make_heap(ranges.begin(), ranges.end(), later);
+    while (!ranges.empty())
+    {
+        std::pop_heap(ranges.begin(), ranges.end(), later);
+        Range &range = ranges.back();
+        write(records_[range.first]);
+        if (++range.first < range.second)
+            std::push_heap(ranges.begin(), ranges.end(), later);
+        else
+            ranges.pop_back();
     }
-    // 线程退出前再 flush 一次
-    output.flush();
+
+    if (outputBuffer_->length() > 0)
+    {
+        writeOutput(output, outputBuffer_->data(), outputBuffer_->length());
+        outputBuffer_->reset();
+    }
+
+    // 写完之后才能释放块，唤醒因为缓冲链满而阻塞的线程。
+    // 超过一个flushInterval没有写日志的线程，写完的块还给总上限；有线程分不到块时所有线程写完的块都还回去
+    bool reclaim = reclaimRequested_.exchange(false, std::memory_order_relaxed);
+    const int64_t now = MonoTimestamp::now().microSeconds();
+    const int64_t idleMicros = static_cast<int64_t>(flushInterval_) * Timestamp::kMicroSecondsPerSecond;
+    for (const ProducerPtr &producer : producers)
+    {
+        producer->commit();
+        totalChunks_.fetch_sub(producer->releaseIdle(reclaim, now, idleMicros), std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    spaceCond_.notify_all();
+    return more;
 }
@@ -13,9 +13,44 @@
 #include <functional>
 #include <chrono>
 
+/**
+ * 异步日志
+ * 前端：每个写日志的线程有自己的缓冲链（单生产者单消费者），append只写本线程的缓冲区，
+ *       不加锁；只有第一次写日志（注册）和写满一个块、需要唤醒后端时才会加锁。
+ * 后端：定时（flushInterval）或者被唤醒时取走所有线程已经提交的日志，按时间戳归并后写入LogFile
+ * 磁盘跟不上时每个线程的缓冲链最多增长到setBufferLimit的上限，所有线程合计不超过setTotalBufferLimit，
+ * 之后按OverflowPolicy处理。内存占用：每个写过日志的线程至少一块（1MB），不再换块的线程多出来的块
+ * 由后端释放，有线程分不到块时所有线程写完的块都会释放，合计最多 max(总上限, 线程数 * 1MB)，
+ * 默认每个线程64MB、合计256MB；
+ * 丢弃的日志计入stats()，由后端在stderr和日志文件中各写一行"dropped N messages"说明，
+ * 写进日志文件的说明可以用setDropMarker换成别的格式（比如二进制日志的记录）或者去掉
+ */
 class AsyncLogging : noncopyable
 {
 public:
+    // 一个线程的缓冲链达到上限、后端还没有腾出块时的处理方式
+    enum OverflowPolicy
+    {
+        kBlockProducer, // 阻塞写日志的线程直到后端写完一块；后端没有运行时按kDropNewest处理
+        kDropNewest,    // 丢弃新写的日志
+        kDropOldest,    // 丢弃后端还没有开始读的最早的一块（1MB）腾出来写新日志，没有这样的块时丢弃新日志
+    };
+
+    struct Stats
+    {
+        uint64_t droppedMessages;
+        uint64_t droppedBytes;
+        uint64_t chunkAllocations; // 分配缓冲块的次数，稳定运行时不再增长
+        uint64_t bufferChunks;     // 当前所有线程的缓冲链占用的块数（每块1MB）
+        uint64_t producerBlocks;   // 写日志的线程因为缓冲链满而阻塞的次数（kBlockProducer）
+        uint64_t writes;           // 后端写文件（LogFile::append/flush）的次数
+        uint64_t writeMicros;      // 写文件的累计耗时
+        uint64_t maxWriteMicros;   // 单次写文件的最大耗时
+    };
+
+    // 返回某个线程丢弃日志之后写进日志文件的说明，返回空串表示不写
+    using DropMarkerFunc = std::function<std::string(uint64_t messages, uint64_t bytes, int tid)>;
+
     // flushInterval：日志刷新时间，rollSize：日志文件最大尺寸
     AsyncLogging(const std::string &basename, off_t rollSize, int flushInterval = 3);
     ~AsyncLogging()
@@ -25,7 +60,7 @@ public:
             stop();
         }
     }
-    // 前端调用 append 写入日志
+    // 前端调用 append 写入日志，任意线程调用
     void append(const char *logline, int len);
     void start()
     {
@@ -35,33 +70,101 @@ public:
     void stop()
     {
         running_ = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_ = true;
+        }
         cond_.notify_one();
+        spaceCond_.notify_all();
         thread_.join();
     }
 
+    // 每个写日志的线程最多占用bytes字节的缓冲（按块向上取整，至少2块），0表示不限制。
+    // 默认64MB、kDropOldest。在start之前调用，已经写过日志的线程仍按原来的设置
+    void setBufferLimit(size_t bytes, OverflowPolicy policy = kDropOldest);
+    // 所有线程的缓冲合计最多bytes字节（按块向上取整），0表示不限制，默认256MB。
+    // 达到总上限后各线程按自己的OverflowPolicy处理，kBlockProducer的线程等后端写完自己的块或者回收别的线程的块。
+    // 每个线程的第一块不受总上限限制。在start之前调用
+    void setTotalBufferLimit(size_t bytes);
+    // 每个日志文件开头写入header()的返回值（见LogFile::setFileHeader），在start之前调用，
+    // header()在后端线程中调用
+    void setFileHeader(LogFile::HeaderFunc header) { fileHeader_ = std::move(header); }
+    // 替换写进日志文件的丢弃说明（默认是一行文本），在start之前调用，marker在后端线程中调用。
+    // 二进制日志用BinaryLog::dropMarker，避免文本混进二进制文件
+    void setDropMarker(DropMarkerFunc marker) { dropMarker_ = std::move(marker); }
+    // Thread safe
+    Stats stats() const;
+
 private:
     using LargeBuffer = FixedBuffer<kLargeBufferSize>;
     using BufferPtr   = std::unique_ptr<LargeBuffer>;
-    using BufferVector = std::vector<BufferPtr>;
+
+    // 每个块1MB，一条日志（不超过kSmallBufferSize）不会跨块
+    static constexpr size_t kChunkSize = 1024 * 1024;
+    // 每个线程缓存几个AsyncLogging的缓冲链，同一个线程交替写几个AsyncLogging时不必反复注册
+    static constexpr size_t kProducerCacheSize = 4;
+
+    struct Chunk;
+    class Producer;
+    using ProducerPtr = std::shared_ptr<Producer>;
+
+    // 后端归并时引用的一条日志，内容仍在生产者的块里
+    struct Record
+    {
+        int64_t time;
+        const char *data;
+        uint32_t len;
+    };
+
+    Producer *localProducer();
+    ProducerPtr registerProducer();
+    void notifyBackend();
+    // 缓冲链已满时按策略处理，返回true表示应当重试
+    bool handleFull(Producer *producer, uint32_t len);
+    // 在总上限之内占用一块，成功时返回true；达到总上限时先回收各线程写完的块，并请后端回收
+    bool reserveChunk();
+    // 释放所有线程已经写完的块，返回释放的块数
+    size_t releaseFreeChunks();
+    bool hasBudget() const;
 
     void threadFunc();
+    // 取走所有线程已提交的日志，按时间戳归并写入output，还有没取完的日志时返回true
+    bool drain(const std::vector<ProducerPtr> &producers, LogFile &output);
+    // 写文件并统计耗时
+    void writeOutput(LogFile &output, const char *data, size_t len);
+    void flushOutput(LogFile &output);
+    void recordWrite(int64_t micros);
 
     const int flushInterval_; // 日志刷新时间
     std::atomic<bool> running_;
     const std::string basename_;
     const off_t rollSize_;
+    const uint64_t id_; // 区分不同的AsyncLogging对象（线程局部缓存用，地址可能被复用）
     Thread thread_;
+    size_t maxChunks_; // 每个线程的块数上限，0表示不限制
+    OverflowPolicy policy_;
+    size_t maxTotalChunks_; // 所有线程的块数上限，0表示不限制
+    std::atomic<size_t> totalChunks_;
+    std::atomic<bool> reclaimRequested_; // 有线程因为总上限分不到块
+    LogFile::HeaderFunc fileHeader_;
+    DropMarkerFunc dropMarker_;
+
+    // 以下由mutex_保护，只在慢路径上使用
     std::mutex mutex_;
     std::condition_variable cond_;
+    std::condition_variable spaceCond_; // 后端写完一批日志，唤醒被阻塞的写日志线程
+    bool pending_; // 有线程写满了一个块
+    std::vector<ProducerPtr> producers_;
 
-    BufferPtr currentBuffer_;
-
-    // 这里拆成两个常量：前端备用缓冲池大小 和 后端备用缓冲池大小
-    static const int frontBuffers = 2; // 前端除 current 外，最多保留 2 张备用
-    static const int backBuffers  = 6; // 后端每次一轮想保留 6 张用于下一轮预分配
+    std::atomic<uint64_t> droppedMessages_;
+    std::atomic<uint64_t> droppedBytes_;
+    std::atomic<uint64_t> chunkAllocations_;
+    std::atomic<uint64_t> producerBlocks_;
+    std::atomic<uint64_t> writes_;
+    std::atomic<uint64_t> writeMicros_;
+    std::atomic<uint64_t> maxWriteMicros_;
 
-    // “前端备用”缓冲区，最多 frontBuffers 个
-    BufferVector freeBuffers_;
-    // “待写队列”：前端写满时把 full buffer push 到这里
-    BufferVector buffers_;
+    // 后端线程使用
+    BufferPtr outputBuffer_; // 归并后的日志先攒到这里，整块写入LogFile
+    std::vector<Record> records_;
 };
@@ -0,0 +1,120 @@
+#include "BinaryLog.h"
+
+#include <mutex>
+#include <vector>
+
+namespace
+{
+std::mutex g_sitesMutex;
+std::vector<BinaryLogSite *> g_sites; // 下标+1就是调用点ID
+Logger::OutputFunc g_binaryOutput;
+BinaryLogSite g_dropSite(Logger::WARN, __FILE__, __LINE__,
+                         "AsyncLogging dropped {} messages ({} bytes) from thread {}, buffer limit reached");
+
+std::vector<BinaryLogSite *> registeredSites()
+{
+    std::lock_guard<std::mutex> lock(g_sitesMutex);
+    return g_sites;
+}
+} // namespace
+
+std::atomic<bool> BinaryLog::enabled_(false);
+
+uint32_t BinaryLogSite::registerSite(const char *types, bool writeDefinition)
+{
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lock(g_sitesMutex);
+        id = id_.load(std::memory_order_relaxed);
+        if (id != 0)
+            return id;
+        // 别的线程正在写定义，直接用它分配的ID，解码时定义晚一点到也没关系
+        if (assignedId_ != 0)
+            return assignedId_;
+        types_ = types;
+        g_sites.push_back(this);
+        id = static_cast<uint32_t>(g_sites.size());
+        assignedId_ = id;
+        if (!writeDefinition)
+        {
+            id_.store(id, std::memory_order_release);
+            return id;
+        }
+    }
+    // 写定义时不持有g_sitesMutex：输出可能阻塞到后端写完，而后端滚动文件时要调用siteTable
+    BinaryLog::writeSite(*this, id);
+    id_.store(id, std::memory_order_release);
+    return id;
+}
+
+void BinaryLog::setOutput(Logger::OutputFunc out)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_sitesMutex);
+        g_binaryOutput = std::move(out);
+        enabled_.store(static_cast<bool>(g_binaryOutput), std::memory_order_relaxed);
+    }
+    writeSiteTable();
+}
+
+void BinaryLog::writeSiteTable()
+{
+    std::vector<BinaryLogSite *> sites = registeredSites();
+    for (size_t i = 0; i < sites.size(); ++i)
+        writeSite(*sites[i], static_cast<uint32_t>(i + 1));
+}
+
+std::string BinaryLog::siteTable()
+{
+    std::vector<BinaryLogSite *> sites = registeredSites();
+    std::string table;
+    char buf[kMaxRecordSize];
+    for (size_t i = 0; i < sites.size(); ++i)
+        table.append(buf, encodeSite(*sites[i], static_cast<uint32_t>(i + 1), buf));
+    return table;
+}
+
+std::string BinaryLog::dropMarker(uint64_t messages, uint64_t bytes, int tid)
+{
+    static constexpr char types[] = {typeOf<uint64_t>(), typeOf<uint64_t>(), typeOf<int>(), '\0'};
+    // 在AsyncLogging的后端线程中调用，注册时不能经过输出函数（kBlockProducer时可能等待后端自己），
+    // 定义记录直接放在说明前面
+    uint32_t id = g_dropSite.id_.load(std::memory_order_acquire);
+    if (id == 0)
+        id = g_dropSite.registerSite(types, false);
+    char buf[kMaxRecordSize];
+    std::string marker(buf, encodeSite(g_dropSite, id, buf));
+    marker.append(buf, encodeRecord(buf, id, messages, bytes, tid));
+    return marker;
+}
+
+void BinaryLog::output(const char *data, int len)
+{
+    if (g_binaryOutput)
+        g_binaryOutput(data, len);
+}
+
+void BinaryLog::writeSite(const BinaryLogSite &site, uint32_t id)
+{
+    char buf[kMaxRecordSize];
+    output(buf, encodeSite(site, id, buf));
+}
+
+int BinaryLog::encodeSite(const BinaryLogSite &site, uint32_t id, char *buf)
+{
+    char *end = buf + kMaxRecordSize;
+    char *cur = buf + sizeof(BinaryLogRecord);
+    cur = put(cur, end, id);
+    cur = put(cur, end, static_cast<uint8_t>(site.level()));
+    cur = put(cur, end, static_cast<uint32_t>(site.line()));
+    cur = putString(cur, end, site.file(), strlen(site.file()));
+    cur = putString(cur, end, site.format(), strlen(site.format()));
+    cur = putString(cur, end, site.types_, strlen(site.types_));
+
+    BinaryLogRecord header;
+    header.size = static_cast<uint32_t>(cur - buf);
+    header.siteId = 0;
+    header.time = Timestamp::now().microSecondsSinceEpoch();
+    memcpy(buf, &header, sizeof header);
+    return static_cast<int>(header.size);
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "Logger.h"
+#include "noncopyable.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * 二进制日志：格式化推迟到离线解码
+ * 每个LOG_BIN_*调用点有一个静态的BinaryLogSite（格式串、文件名、行号、等级），第一次执行时注册，
+ * 分配一个调用点ID，并向输出写一条定义记录；之后每次只把时间戳、调用点ID和参数的原始字节拷贝进一条记录，
+ * 交给输出函数（一般是另一个AsyncLogging的append），不做任何文本格式化。
+ * 格式串用{}作为参数占位符，例如：
+ *     LOG_BIN_INFO("connection {} from {} closed after {} s", fd, peer, seconds);
+ * LogFile写出的二进制文件用 Logger/tools/logdecoder 还原成文本。
+ * 定义记录在注册时写一次；输出是AsyncLogging时用setFileHeader(BinaryLog::siteTable)让每个日志文件开头
+ * 都带上全部已注册的定义，滚动出的文件可以单独解码，kDropOldest丢掉的定义也会在下一个文件中补上：
+ *     binaryLog.setFileHeader(BinaryLog::siteTable);
+ * 多个线程同时写时，定义记录可能排在第一次使用它的记录之后，logdecoder先读完整个文件的定义再解码。
+ */
+
+// 文件格式：连续的记录，每条以BinaryLogRecord开头
+struct BinaryLogRecord
+{
+    uint32_t size;   // 整条记录的字节数，包括头部
+    uint32_t siteId; // 调用点ID，0表示这是一条调用点定义
+    int64_t time;    // 墙上时间，微秒
+};
+
+// 参数类型编码，调用点定义中按参数顺序记录，解码时按它读取参数
+namespace BinaryLogType
+{
+const char kInt = 'i';    // int64_t
+const char kUint = 'u';   // uint64_t
+const char kDouble = 'd'; // double
+const char kChar = 'c';   // char
+const char kBool = 'b';   // uint8_t
+const char kPointer = 'p';// uint64_t，按十六进制显示
+const char kString = 's'; // uint16_t长度 + 内容
+} // namespace BinaryLogType
+
+/**
+ * 调用点定义记录（siteId == 0）的内容：
+ *   uint32_t id; uint8_t level; uint32_t line;
+ *   然后依次是文件名、格式串、参数类型串，每个都是uint16_t长度 + 内容
+ */
+
+class BinaryLogSite : noncopyable
+{
+public:
+    constexpr BinaryLogSite(Logger::LogLevel level, const char *file, int line, const char *format)
+        : level_(level), file_(file), line_(line), format_(format), id_(0)
+    {
+    }
+
+    Logger::LogLevel level() const { return level_; }
+    const char *file() const { return file_; }
+    int line() const { return line_; }
+    const char *format() const { return format_; }
+
+    // 没有注册时注册，返回调用点ID
+    uint32_t id(const char *types)
+    {
+        uint32_t id = id_.load(std::memory_order_acquire);
+        return id != 0 ? id : registerSite(types);
+    }
+
+private:
+    // writeDefinition为false时不向输出写定义记录，由调用者自己写
+    uint32_t registerSite(const char *types, bool writeDefinition = true);
+
+    const Logger::LogLevel level_;
+    const char *const file_;
+    const int line_;
+    const char *const format_;
+    const char *types_ = nullptr;
+    uint32_t assignedId_ = 0; // 已经分配、但定义可能还没写完时id_仍为0，由g_sitesMutex保护
+    std::atomic<uint32_t> id_;
+
+    friend class BinaryLog;
+};
+
+class BinaryLog
+{
+public:
+    // 一条记录的最大长度，超出部分的字符串参数被截断
+    static const int kMaxRecordSize = kSmallBufferSize;
+
+    // 设置输出函数，并把已经注册的调用点定义写到新的输出；没有设置时LOG_BIN_*什么也不做
+    static void setOutput(Logger::OutputFunc out);
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+    // 把所有调用点定义重新写一遍，新文件可以单独解码
+    static void writeSiteTable();
+    // 所有已注册的调用点定义记录，用作日志文件的开头（AsyncLogging::setFileHeader）
+    static std::string siteTable();
+    // AsyncLogging丢弃日志的说明，编码成一条WARN记录（前面带上它的调用点定义），用于AsyncLogging::setDropMarker
+    static std::string dropMarker(uint64_t messages, uint64_t bytes, int tid);
+
+    template <typename... Args>
+    static void log(BinaryLogSite &site, const Args &...args)
+    {
+        static constexpr char types[] = {typeOf<Args>()..., '\0'};
+        char buf[kMaxRecordSize];
+        output(buf, encodeRecord(buf, site.id(types), args...));
+    }
+
+private:
+    friend class BinaryLogSite;
+
+    static void output(const char *data, int len);
+    static void writeSite(const BinaryLogSite &site, uint32_t id);
+    // 把调用点定义记录编码到buf（kMaxRecordSize字节），返回长度
+    static int encodeSite(const BinaryLogSite &site, uint32_t id, char *buf);
+
+    // 把一条日志记录编码到buf（kMaxRecordSize字节），返回长度
+    template <typename... Args>
+    static int encodeRecord(char *buf, uint32_t siteId, const Args &...args)
+    {
+        BinaryLogRecord header;
+        header.siteId = siteId;
+        header.time = Timestamp::now().microSecondsSinceEpoch();
+        char *end = buf + sizeof header;
+        // 逐个参数原样拷贝
+        int dummy[] = {0, (end = encode(end, buf + kMaxRecordSize, args), 0)...};
+        (void)dummy;
+        header.size = static_cast<uint32_t>(end - buf);
+        memcpy(buf, &header, sizeof header);
+        return static_cast<int>(header.size);
+    }
+
+    template <typename T>
+    static constexpr char typeOf()
+    {
+        using U = typename std::decay<T>::type;
+        if (std::is_same<U, bool>::value)
+            return BinaryLogType::kBool;
+        else if (std::is_same<U, char>::value)
+            return BinaryLogType::kChar;
+        else if (std::is_enum<U>::value)
+            return BinaryLogType::kInt;
+        else if (std::is_integral<U>::value)
+            return std::is_signed<U>::value ? BinaryLogType::kInt : BinaryLogType::kUint;
+        else if (std::is_floating_point<U>::value)
+            return BinaryLogType::kDouble;
+        else if (std::is_same<U, char *>::value || std::is_same<U, const char *>::value ||
+                 std::is_same<U, std::string>::value || std::is_same<U, std::string_view>::value)
+            return BinaryLogType::kString;
+        else if (std::is_pointer<U>::value)
+            return BinaryLogType::kPointer;
+        else
+            return '?';
+    }
+
+    template <typename T>
+    static char *put(char *cur, char *end, const T &value)
+    {
+        if (cur + sizeof value > end)
+            return cur;
+        memcpy(cur, &value, sizeof value);
+        return cur + sizeof value;
+    }
+
+    static char *putString(char *cur, char *end, const char *str, size_t len)
+    {
+        if (cur + sizeof(uint16_t) > end)
+            return cur;
+        size_t room = static_cast<size_t>(end - cur) - sizeof(uint16_t);
+        uint16_t n = static_cast<uint16_t>(len < room ? len : room);
+        memcpy(cur, &n, sizeof n);
+        memcpy(cur + sizeof n, str, n);
+        return cur + sizeof n + n;
+    }
+
+    template <typename T>
+    static char *encode(char *cur, char *end, const T &value)
+    {
+        using U = typename std::decay<T>::type;
+        static_assert(typeOf<U>() != '?', "unsupported LOG_BIN argument type");
+        if constexpr (std::is_same<U, bool>::value)
+            return put(cur, end, static_cast<uint8_t>(value));
+        else if constexpr (std::is_same<U, char>::value)
+            return put(cur, end, value);
+        else if constexpr (std::is_enum<U>::value)
+            return put(cur, end, static_cast<int64_t>(value));
+        else if constexpr (std::is_integral<U>::value)
+            return std::is_signed<U>::value ? put(cur, end, static_cast<int64_t>(value))
+                                            : put(cur, end, static_cast<uint64_t>(value));
+        else if constexpr (std::is_floating_point<U>::value)
+            return put(cur, end, static_cast<double>(value));
+        else if constexpr (std::is_same<U, std::string>::value || std::is_same<U, std::string_view>::value)
+            return putString(cur, end, value.data(), value.size());
+        else if constexpr (std::is_same<U, char *>::value || std::is_same<U, const char *>::value)
+            return value ? putString(cur, end, value, strlen(value)) : putString(cur, end, "(null)", 6);
+        else
+            return put(cur, end, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+    }
+
+    static std::atomic<bool> enabled_;
+};
+
+#define LOG_BIN(level, format, ...)                                                   \
+    do                                                                                \
+    {                                                                                 \
+        if ((level) >= LOG_MIN_LEVEL && BinaryLog::enabled() &&                       \
+            (level) >= Logger::logLevel())                                            \
+        {                                                                             \
+            static BinaryLogSite binaryLogSite_((level), __FILE__, __LINE__, format); \
+            BinaryLog::log(binaryLogSite_, ##__VA_ARGS__);                            \
+        }                                                                             \
+    } while (0)
+
+#define LOG_BIN_TRACE(format, ...) LOG_BIN(Logger::TRACE, format, ##__VA_ARGS__)
+#define LOG_BIN_DEBUG(format, ...) LOG_BIN(Logger::DEBUG, format, ##__VA_ARGS__)
+#define LOG_BIN_INFO(format, ...) LOG_BIN(Logger::INFO, format, ##__VA_ARGS__)
+#define LOG_BIN_WARN(format, ...) LOG_BIN(Logger::WARN, format, ##__VA_ARGS__)
+#define LOG_BIN_ERROR(format, ...) LOG_BIN(Logger::ERROR, format, ##__VA_ARGS__)
@@ -1,22 +1,99 @@
+#include <algorithm>
 #include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "FileUtil.h"
 
-FileUtil::FileUtil(std::string &file_name) : file_(::fopen(file_name.c_str(), "ae")),
-                                             writtenBytes_(0)
+namespace
 {
-    // 将file_缓冲区设置为本地缓冲降低io次数。
-    ::setbuffer(file_, buffer_, sizeof(buffer_));
+// 写文件的方式，进程启动后第一次打开文件时读取环境变量 LOG_FILE_WRITE
+bool useDirectWrite()
+{
+    static const bool direct = [] {
+        const char *mode = ::getenv("LOG_FILE_WRITE");
+        return mode != nullptr && ::strcmp(mode, "direct") == 0;
+    }();
+    return direct;
+}
+} // namespace
+
+FileUtil::FileUtil(const std::string &file_name, off_t preallocate) : file_(nullptr),
+                                                                      fd_(-1),
+                                                                      directBuffer_(nullptr),
+                                                                      used_(0),
+                                                                      flushed_(0),
+                                                                      offset_(0),
+                                                                      preallocated_(false),
+                                                                      writtenBytes_(0)
+{
+    if (useDirectWrite())
+    {
+        fd_ = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+        void *buffer = nullptr;
+        if (fd_ < 0 || ::posix_memalign(&buffer, kDirectAlignment, kDirectChunkSize) != 0)
+        {
+            fprintf(stderr, "FileUtil::FileUtil() open %s failed %s\n", file_name.c_str(), strerror(errno));
+            return;
+        }
+        directBuffer_ = static_cast<char *>(buffer);
+        // 和"a"模式一样接着已有的内容写
+        offset_ = ::lseek(fd_, 0, SEEK_END);
+    }
+    else
+    {
+        file_ = ::fopen(file_name.c_str(), "ae");
+        // 将file_缓冲区设置为本地缓冲降低io次数。
+        ::setbuffer(file_, buffer_, sizeof(buffer_));
+        fd_ = ::fileno(file_);
+    }
+    // KEEP_SIZE：只分配磁盘块，文件长度仍是实际写入的长度，文本日志末尾不会出现一段0
+    // 文件系统不支持时忽略，只是退回到逐次扩展文件
+    if (preallocate > 0 && ::fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, preallocate) == 0)
+    {
+        preallocated_ = true;
+    }
 }
 FileUtil::~FileUtil()
 {
+    if (directBuffer_)
+    {
+        flush();
+        ::free(directBuffer_);
+    }
+    if (file_)
+    {
+        ::fflush(file_);
+    }
+    // KEEP_SIZE分配的块在关闭文件时不会释放，截断到实际长度把没用到的部分还给文件系统
+    struct stat st;
+    if (preallocated_ && ::fstat(fd_, &st) == 0)
+    {
+        ::ftruncate(fd_, st.st_size);
+    }
     if (file_)
     {
         ::fclose(file_);
     }
+    else if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
 }
 // 向文件写入数据
 void FileUtil::append(const char *data, size_t len)
 {
+    if (directBuffer_)
+    {
+        appendDirect(data, len);
+        return;
+    }
+    if (file_ == nullptr)
+    {
+        return; // direct写打开文件失败
+    }
     size_t writen = 0;
     while (writen != len)
     {
@@ -40,11 +117,71 @@ void FileUtil::append(const char *data, size_t len)
 
 void FileUtil::flush()
 {
-    ::fflush(file_);
+    if (directBuffer_)
+    {
+        // 只写出上次flush之后的部分，缓冲区留着，攒满之后整块再写一遍
+        if (used_ > flushed_)
+        {
+            writeAt(directBuffer_ + flushed_, used_ - flushed_, offset_ + static_cast<off_t>(flushed_));
+            flushed_ = used_;
+        }
+        return;
+    }
+    if (file_)
+    {
+        ::fflush(file_);
+    }
 }
 // 真正向文件写入数据
 size_t FileUtil::write(const char *data, size_t len)
 {
     // 没用选择线程安全的fwrite()为性能考虑。
    return  ::fwrite_unlocked(data, 1, len, file_);
-}
\ No newline at end of file
+}
+
+void FileUtil::appendDirect(const char *data, size_t len)
+{
+    writtenBytes_ += len;
+    // 缓冲区为空时整块的数据直接从调用者的内存写出，省一次拷贝
+    while (used_ == 0 && len >= kDirectChunkSize)
+    {
+        size_t n = len / kDirectChunkSize * kDirectChunkSize;
+        writeAt(data, n, offset_);
+        offset_ += n;
+        data += n;
+        len -= n;
+    }
+    while (len > 0)
+    {
+        size_t n = std::min(len, kDirectChunkSize - used_);
+        ::memcpy(directBuffer_ + used_, data, n);
+        used_ += n;
+        data += n;
+        len -= n;
+        if (used_ == kDirectChunkSize)
+        {
+            // 整块写出：偏移和长度都是块对齐的，已经flush过的前一部分重写一遍，内容不变
+            writeAt(directBuffer_, used_, offset_);
+            offset_ += used_;
+            used_ = flushed_ = 0;
+        }
+    }
+}
+
+void FileUtil::writeAt(const char *data, size_t len, off_t offset)
+{
+    while (len > 0)
+    {
+        ssize_t n = ::pwrite(fd_, data, len, offset);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "FileUtil::writeAt() failed %s\n", strerror(errno));
+            return;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+        offset += n;
+    }
+}
@@ -0,0 +1,108 @@
+#include "FlightRecorder.h"
+#include "Timestamp.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+const size_t kHeaderSize = 4096;
+const char kMagic[8] = {'F', 'L', 'I', 'G', 'H', 'T', 'R', '1'};
+
+uint64_t roundUpPowerOfTwo(uint64_t n)
+{
+    uint64_t result = FlightRecorder::kMinCapacity;
+    while (result < n)
+        result <<= 1;
+    return result;
+}
+} // namespace
+
+FlightRecorder::FlightRecorder(const std::string &path, size_t capacity)
+    : header_(nullptr), ring_(nullptr), capacity_(roundUpPowerOfTwo(capacity)), mappedSize_(kHeaderSize + capacity_)
+{
+    // 保留上一次运行（可能是崩溃）的记录
+    if (::access(path.c_str(), F_OK) == 0)
+    {
+        std::string prev = path + ".prev";
+        ::rename(path.c_str(), prev.c_str());
+    }
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        fprintf(stderr, "FlightRecorder open %s failed %s\n", path.c_str(), strerror(errno));
+        return;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(mappedSize_)) != 0)
+    {
+        fprintf(stderr, "FlightRecorder ftruncate %s failed %s\n", path.c_str(), strerror(errno));
+        ::close(fd);
+        return;
+    }
+    // MAP_SHARED：进程退出后页缓存里的内容属于文件；MAP_POPULATE：预先建立映射，append时不缺页
+    void *addr = ::mmap(nullptr, mappedSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        fprintf(stderr, "FlightRecorder mmap %s failed %s\n", path.c_str(), strerror(errno));
+        return;
+    }
+
+    FlightRecorderHeader *header = static_cast<FlightRecorderHeader *>(addr);
+    header->capacity = capacity_;
+    header->dataOffset = kHeaderSize;
+    header->startTime = Timestamp::now().microSecondsSinceEpoch();
+    header->pid = static_cast<int32_t>(::getpid());
+    header->reserved = 0;
+    // 从capacity开始编号，文件中全0的头部（pos == 0）永远不会被当成有效记录
+    header->head.store(capacity_, std::memory_order_relaxed);
+    memcpy(header->magic, kMagic, sizeof kMagic);
+
+    ring_ = static_cast<char *>(addr) + kHeaderSize;
+    header_ = header;
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    // 不需要msync，映射的页由内核写回
+    if (header_ != nullptr)
+        ::munmap(header_, mappedSize_);
+}
+
+void FlightRecorder::append(const char *data, int len)
+{
+    if (header_ == nullptr || len <= 0)
+        return;
+    uint32_t n = static_cast<uint32_t>(len);
+    if (n > capacity_ / 4)
+        n = static_cast<uint32_t>(capacity_ / 4);
+
+    const uint64_t size = recordSize(n);
+    const uint64_t pos = header_->head.fetch_add(size, std::memory_order_relaxed);
+    // 先写长度和内容，最后写pos，崩溃时写了一半的记录解码时会被跳过
+    uint32_t fields[2] = {n, 0};
+    copyIn(pos + sizeof(uint64_t), fields, sizeof fields);
+    copyIn(pos + sizeof(FlightRecord), data, n);
+    FlightRecord *record = reinterpret_cast<FlightRecord *>(ring_ + (pos & (capacity_ - 1)));
+    record->pos.store(pos, std::memory_order_release);
+}
+
+void FlightRecorder::copyIn(uint64_t pos, const void *data, size_t len)
+{
+    size_t offset = static_cast<size_t>(pos & (capacity_ - 1));
+    size_t first = static_cast<size_t>(capacity_) - offset;
+    if (len <= first)
+    {
+        memcpy(ring_ + offset, data, len);
+    }
+    else
+    {
+        memcpy(ring_ + offset, data, first);
+        memcpy(ring_, static_cast<const char *>(data) + first, len - first);
+    }
+}
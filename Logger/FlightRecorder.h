@@ -0,0 +1,71 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/**
+ * 飞行记录器：mmap一个固定大小的文件作为环形缓冲，日志行直接拷贝进映射的内存，
+ * 不做系统调用，也不经过后端线程。进程abort（LOG_FATAL）或者崩溃之后，写进去的内容仍在页缓存里，
+ * 由内核写回文件，用 Logger/tools/flightdecoder 按顺序还原最后的若干日志（机器掉电、内核崩溃除外）。
+ * 一般和 Logger::setFlightRecorder 一起常开DEBUG日志：
+ *     FlightRecorder recorder("/tmp/app.flight", 64 * 1024 * 1024);
+ *     Logger::setLogLevel(Logger::DEBUG);
+ *     Logger::setFlightRecorder(&recorder, Logger::INFO); // DEBUG只进飞行记录器，INFO以上照常输出
+ * 打开时文件已经存在的话先改名为 path.prev，保留上一次运行的记录。
+ */
+
+// 文件格式：一页的文件头，之后是capacity字节的环
+struct FlightRecorderHeader
+{
+    char magic[8];       // "FLIGHTR1"
+    uint64_t capacity;   // 环的字节数，2的幂
+    uint64_t dataOffset; // 环在文件中的偏移
+    int64_t startTime;   // 创建时间，微秒
+    int32_t pid;
+    uint32_t reserved;
+    // 下一条记录的绝对位置，从capacity开始单调递增，环内偏移是head % capacity
+    std::atomic<uint64_t> head;
+};
+
+/**
+ * 环中的一条记录：头部后面紧跟len字节的内容，按8字节对齐，可以绕过环的末尾接到开头。
+ * pos是本条的绝对位置，写完内容之后最后写（release），解码时pos和位置对得上才算一条完整的、
+ * 没有被下一圈覆盖的记录；pos总在8字节对齐的位置上，不会被环的末尾截断
+ */
+struct FlightRecord
+{
+    std::atomic<uint64_t> pos;
+    uint32_t len;
+    uint32_t reserved;
+};
+
+class FlightRecorder : noncopyable
+{
+public:
+    static const size_t kMinCapacity = 64 * 1024;
+
+    // capacity向上取整到2的幂，至少kMinCapacity；打开失败时valid()为false，append什么也不做
+    FlightRecorder(const std::string &path, size_t capacity);
+    ~FlightRecorder();
+
+    bool valid() const { return header_ != nullptr; }
+    size_t capacity() const { return static_cast<size_t>(capacity_); }
+
+    // 任意线程调用，不加锁；一条最多capacity/4字节，超出的部分截掉
+    void append(const char *data, int len);
+
+    static uint64_t recordSize(uint32_t len) { return (sizeof(FlightRecord) + len + 7) & ~static_cast<uint64_t>(7); }
+
+private:
+    // 环形拷贝，处理绕过末尾的情况
+    void copyIn(uint64_t pos, const void *data, size_t len);
+
+    FlightRecorderHeader *header_;
+    char *ring_;
+    uint64_t capacity_;
+    size_t mappedSize_;
+};
@@ -1,4 +1,55 @@
 #include "LogFile.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+
+namespace
+{
+std::atomic<int> g_preparedFiles(0);
+
+// 同一进程里可能有多个LogFile用同一个basename，多个进程也可能写同一个目录，预先创建的文件名要各不相同
+std::string preparedFilename(const std::string &basename)
+{
+    char buf[64];
+    snprintf(buf, sizeof buf, ".next.%d.%d", static_cast<int>(::getpid()),
+             g_preparedFiles.fetch_add(1, std::memory_order_relaxed));
+    return basename + buf;
+}
+
+// 删除已经退出的进程留下的basename.next.<pid>.<序号>，进程还在（或者无法判断）的不动
+void removeStalePreparedFiles(const std::string &basename)
+{
+    size_t slash = basename.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : basename.substr(0, slash == 0 ? 1 : slash);
+    std::string prefix = (slash == std::string::npos ? basename : basename.substr(slash + 1)) + ".next.";
+    DIR *d = ::opendir(dir.c_str());
+    if (d == nullptr)
+        return;
+    while (struct dirent *entry = ::readdir(d))
+    {
+        const char *name = entry->d_name;
+        if (strncmp(name, prefix.c_str(), prefix.size()) != 0)
+            continue;
+        char *end = nullptr;
+        long pid = strtol(name + prefix.size(), &end, 10);
+        if (end == name + prefix.size() || *end != '.' || pid <= 0 || pid == ::getpid())
+            continue;
+        if (::kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH)
+            continue;
+        std::string path = dir + "/" + name;
+        ::unlink(path.c_str());
+    }
+    ::closedir(d);
+}
+} // namespace
+
 LogFile::LogFile(const std::string &basename,
                  off_t rollsize,
                  int flushInterval,
@@ -6,14 +57,33 @@ LogFile::LogFile(const std::string &basename,
                                            rollsize_(rollsize),
                                            flushInterval_(flushInterval),
                                            checkEveryN_(checkEveryN),
+                                           count_(0),
                                            startOfPeriod_(0),
                                            lastRoll_(0),
-                                           lastFlush_(0)
+                                           lastFlush_(0),
+                                           nextFilename_(preparedFilename(basename)),
+                                           quit_(false),
+                                           prepareThread_(std::bind(&LogFile::prepareThreadFunc, this), "LogFilePrepare")
 {
     // 重新启动时，可能没有log文件，因此在构建logFile对象，直接调用rollfile()创建一个新的log文件
     rollFile();
+    prepareThread_.start();
+}
+LogFile::~LogFile()
+{
+    {
+        std::lock_guard<std::mutex> lock(prepareMutex_);
+        quit_ = true;
+    }
+    prepareCond_.notify_one();
+    prepareThread_.join();
+    // 没有用上的预先创建的文件
+    if (preparedFile_)
+    {
+        preparedFile_.reset();
+        ::unlink(nextFilename_.c_str());
+    }
 }
-LogFile::~LogFile() = default;
 void LogFile::append(const char *data, int len)
 {
     std::lock_guard<std::mutex> lg(mutex_);
@@ -34,12 +104,101 @@ bool LogFile::rollFile()
         lastFlush_ = now;
         lastRoll_ = now;
         startOfPeriod_ = start;
-        // 让file_指向一个名为filename的文件，相当于新建了一个文件，但是rollfile一次就会创建一共file对象去将数据写到日志文件中
-        file_.reset(new FileUtil(filename));
+        // 让file_指向一个名为filename的文件，优先用后台线程预先创建好的，没有准备好时同步打开
+        std::unique_ptr<FileUtil> file = takePreparedFile(filename);
+        if (!file)
+        {
+            file.reset(new FileUtil(filename, rollsize_));
+        }
+        file.swap(file_);
+        writeHeader();
+        if (file)
+        {
+            // 旧文件交给后台线程关闭
+            std::lock_guard<std::mutex> lock(prepareMutex_);
+            retiredFile_ = std::move(file);
+        }
+        prepareCond_.notify_one();
         return true;
     }
     return false;
 }
+void LogFile::setFileHeader(HeaderFunc header)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    header_ = std::move(header);
+    if (file_->writtenBytes() == 0)
+        writeHeader();
+}
+
+void LogFile::writeHeader()
+{
+    if (header_)
+    {
+        std::string header = header_();
+        file_->append(header.data(), header.size());
+    }
+}
+
+std::unique_ptr<FileUtil> LogFile::takePreparedFile(const std::string &filename)
+{
+    // 改名/删除也在锁内做完：preparedFile_变空之后后台线程就会删掉nextFilename_重新创建
+    std::lock_guard<std::mutex> lock(prepareMutex_);
+    std::unique_ptr<FileUtil> file = std::move(preparedFile_);
+    if (!file)
+        return file;
+    // 不能覆盖同名文件：别的进程或者同一basename的另一个LogFile可能在同一秒滚动，已有的文件里是它写的日志
+    int ret = ::renameat2(AT_FDCWD, nextFilename_.c_str(), AT_FDCWD, filename.c_str(), RENAME_NOREPLACE);
+    if (ret != 0 && (errno == EINVAL || errno == ENOSYS))
+    {
+        // 内核或文件系统不支持RENAME_NOREPLACE，link在目标已存在时同样失败
+        ret = ::link(nextFilename_.c_str(), filename.c_str());
+        if (ret == 0)
+            ::unlink(nextFilename_.c_str());
+    }
+    if (ret != 0)
+    {
+        // 删掉预先创建的文件，由调用者以追加方式打开已有的文件
+        if (errno != EEXIST)
+            fprintf(stderr, "LogFile::rollFile() rename %s failed %s\n", nextFilename_.c_str(), strerror(errno));
+        ::unlink(nextFilename_.c_str());
+        file.reset();
+    }
+    return file;
+}
+
+void LogFile::prepareThreadFunc()
+{
+    removeStalePreparedFiles(basename_);
+    for (;;)
+    {
+        std::unique_ptr<FileUtil> retired;
+        bool prepare = false;
+        {
+            std::unique_lock<std::mutex> lock(prepareMutex_);
+            prepareCond_.wait(lock, [this] { return quit_ || retiredFile_ || !preparedFile_; });
+            if (quit_)
+            {
+                break;
+            }
+            retired = std::move(retiredFile_);
+            prepare = !preparedFile_;
+        }
+        // 关闭旧文件：写出stdio缓冲、释放没用到的预分配空间
+        retired.reset();
+        if (prepare)
+        {
+            // 崩溃的进程留下的文件，pid被本进程复用时可能重名
+            ::unlink(nextFilename_.c_str());
+            std::unique_ptr<FileUtil> file(new FileUtil(nextFilename_, rollsize_));
+            std::lock_guard<std::mutex> lock(prepareMutex_);
+            preparedFile_ = std::move(file);
+        }
+    }
+    std::lock_guard<std::mutex> lock(prepareMutex_);
+    retiredFile_.reset();
+}
+
 // 日志格式basename+now+".log"
 std::string LogFile::getLogFileName(const std::string &basename, time_t *now)
 {
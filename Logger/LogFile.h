@@ -1,16 +1,26 @@
 #pragma once
 #include "FileUtil.h"
+#include "Thread.h"
 #include <mutex>
 #include <memory>
+#include <condition_variable>
 #include <ctime>
+#include <functional>
+#include <string>
 /**
  * @brief 日志文件管理类
  * 负责日志文件的创建、写入、滚动和刷新等操作
  * 支持按大小和时间自动滚动日志文件
+ * 后台线程预先创建好下一个文件（basename.next.<pid>.<序号>，每个LogFile对象不同，fallocate到rollsize），
+ * 滚动时只需rename；已经退出的进程留下的这类文件由后台线程启动时删除。
+ * 旧文件也交给后台线程关闭，写日志的线程在滚动时不做打开、关闭文件和分配磁盘块这些慢操作
  */
 class LogFile
 {
 public:
+    // 返回每个新文件开头要写的内容
+    using HeaderFunc = std::function<std::string()>;
+
     /**
      * @brief 构造函数
      * @param basename 日志文件基本名称
@@ -42,11 +52,26 @@ public:
      */
     bool rollFile();
 
+    /**
+     * @brief 之后滚动出的每个文件开头先写header()返回的内容，当前文件还没有写过内容时立即写入
+     * 例如二进制日志的调用点定义表（BinaryLog::siteTable），让每个文件都可以单独解码。
+     * header()在写日志的线程中、持有本对象的锁时调用，不能再写本LogFile
+     */
+    void setFileHeader(HeaderFunc header);
+
 private:
+    void writeHeader();
+
     /**
-     * @brief 禁用析构函数，使用智能指针管理
+     * @brief 后台线程：保持有一个预先创建好的文件，关闭滚动下来的旧文件
      */
+    void prepareThreadFunc();
 
+    /**
+     * @brief 取走预先创建好的文件并改名为filename
+     * @return 后台线程还没有准备好时返回空
+     */
+    std::unique_ptr<FileUtil> takePreparedFile(const std::string &filename);
 
     /**
      * @brief 生成日志文件名
@@ -75,5 +100,15 @@ private:
     time_t lastRoll_;// 上次roll日志文件时间(秒)
     time_t lastFlush_; // 上次flush日志文件时间(秒)
     std::unique_ptr<FileUtil> file_;
+    HeaderFunc header_;
     const static int kRollPerSeconds_ = 60*60*24;
+
+    // 以下由prepareMutex_保护
+    const std::string nextFilename_; // 预先创建的文件名，basename.next.<pid>.<序号>
+    std::mutex prepareMutex_;
+    std::condition_variable prepareCond_;
+    std::unique_ptr<FileUtil> preparedFile_;
+    std::unique_ptr<FileUtil> retiredFile_; // 滚动下来等待后台线程关闭的文件
+    bool quit_;
+    Thread prepareThread_;
 };
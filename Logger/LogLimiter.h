@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Logger.h"
+#include "noncopyable.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * 按调用点限流/采样的日志，用于出错时每个事件都会触发的语句（例如accept返回EMFILE），避免日志洪水：
+ *   LOG_ERROR_RATELIMIT(10) << "accept Err";   每秒最多输出10条，之后的被丢弃并计数，
+ *                                               下一秒第一条输出之前先输出一行"suppressed N ..."汇总
+ *   LOG_DEBUG_SAMPLED(100) << ...;              每100条输出1条，输出的行带"[sampled 1/100]"前缀
+ * 每个调用点一个静态的限流器/采样器，快路径上只有一次relaxed的原子fetch_add
+ * （限流器另外读一次CLOCK_MONOTONIC_COARSE，vDSO中只读内存，不陷入内核）
+ * 和LOG_*一样先按编译期/运行时的日志等级过滤，被等级过滤掉的语句不计数
+ */
+class LogRateLimiter : noncopyable
+{
+public:
+    constexpr explicit LogRateLimiter(uint32_t perSecond)
+        : limit_(perSecond), window_(0), count_(0), suppressed_(0)
+    {
+    }
+
+    // 本条被丢弃时返回-1；否则返回自上次汇总以来被丢弃的条数，调用者输出本条（和汇总）
+    int64_t check()
+    {
+        int64_t second = coarseSecond();
+        if (second == window_.load(std::memory_order_relaxed))
+        {
+            return count_.fetch_add(1, std::memory_order_relaxed) < limit_ ? 0 : -1;
+        }
+        return rollover(second);
+    }
+
+    // 累计丢弃的条数（包括当前窗口）
+    uint64_t suppressed() const
+    {
+        uint32_t n = count_.load(std::memory_order_relaxed);
+        return suppressed_.load(std::memory_order_relaxed) + (n > limit_ ? n - limit_ : 0);
+    }
+
+private:
+    static int64_t coarseSecond()
+    {
+        struct timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return static_cast<int64_t>(ts.tv_sec);
+    }
+
+    // 进入新的一秒：只有一个线程换窗口并取走上一个窗口的计数，其它线程按新窗口计数
+    int64_t rollover(int64_t second)
+    {
+        int64_t old = window_.load(std::memory_order_relaxed);
+        if (old != second && window_.compare_exchange_strong(old, second, std::memory_order_relaxed))
+        {
+            uint32_t n = count_.exchange(1, std::memory_order_relaxed);
+            uint32_t suppressed = n > limit_ ? n - limit_ : 0;
+            suppressed_.fetch_add(suppressed, std::memory_order_relaxed);
+            return suppressed;
+        }
+        return count_.fetch_add(1, std::memory_order_relaxed) < limit_ ? 0 : -1;
+    }
+
+    const uint32_t limit_;
+    std::atomic<int64_t> window_;     // 当前窗口（单调时钟秒数）
+    std::atomic<uint32_t> count_;     // 当前窗口内的条数，包括被丢弃的
+    std::atomic<uint64_t> suppressed_; // 之前各个窗口丢弃的条数，只在换窗口时累加
+};
+
+class LogSampler : noncopyable
+{
+public:
+    constexpr explicit LogSampler(uint32_t every)
+        : every_(every > 0 ? every : 1), count_(0)
+    {
+    }
+
+    // 每every条的第一条返回true
+    bool sample() { return count_.fetch_add(1, std::memory_order_relaxed) % every_ == 0; }
+
+    uint32_t every() const { return every_; }
+    // 累计丢弃的条数
+    uint64_t suppressed() const
+    {
+        uint64_t n = count_.load(std::memory_order_relaxed);
+        return n - (n + every_ - 1) / every_;
+    }
+
+private:
+    const uint32_t every_;
+    std::atomic<uint64_t> count_;
+};
+
+// 限流后恢复输出时，在本条之前输出被丢弃条数的汇总
+inline void logSuppressed(const char *file, int line, Logger::LogLevel level, int64_t count)
+{
+    if (count > 0)
+        Logger(file, line, level).stream() << "suppressed " << count << " messages from this call site";
+}
+
+#define LOG_RATELIMIT(level, perSecond)                                                   \
+    if ((level) < LOG_MIN_LEVEL || (level) < Logger::logLevel())                          \
+        ;                                                                                 \
+    else if (static LogRateLimiter logRateLimiter_(perSecond); false)                     \
+        ;                                                                                 \
+    else if (int64_t logSuppressed_ = logRateLimiter_.check(); logSuppressed_ < 0)        \
+        ;                                                                                 \
+    else                                                                                  \
+        logSuppressed(__FILE__, __LINE__, (level), logSuppressed_),                       \
+            Logger(__FILE__, __LINE__, (level)).stream()
+
+#define LOG_SAMPLED(level, oneIn)                                                         \
+    if ((level) < LOG_MIN_LEVEL || (level) < Logger::logLevel())                          \
+        ;                                                                                 \
+    else if (static LogSampler logSampler_(oneIn); !logSampler_.sample())                 \
+        ;                                                                                 \
+    else                                                                                  \
+        Logger(__FILE__, __LINE__, (level)).stream() << "[sampled 1/" << logSampler_.every() << "] "
+
+#define LOG_INFO_RATELIMIT(perSecond) LOG_RATELIMIT(Logger::INFO, perSecond)
+#define LOG_WARN_RATELIMIT(perSecond) LOG_RATELIMIT(Logger::WARN, perSecond)
+#define LOG_ERROR_RATELIMIT(perSecond) LOG_RATELIMIT(Logger::ERROR, perSecond)
+
+#define LOG_TRACE_SAMPLED(oneIn) LOG_SAMPLED(Logger::TRACE, oneIn)
+#define LOG_DEBUG_SAMPLED(oneIn) LOG_SAMPLED(Logger::DEBUG, oneIn)
+#define LOG_INFO_SAMPLED(oneIn) LOG_SAMPLED(Logger::INFO, oneIn)
+#define LOG_WARN_SAMPLED(oneIn) LOG_SAMPLED(Logger::WARN, oneIn)
@@ -1,33 +1,91 @@
 #include "LogStream.h"
 #include <algorithm>
+#include <charconv>
+#include <type_traits>
 
-static const char digits[] = "9876543210123456789";
+namespace detail
+{
+const char kDigitPairs[201] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+namespace
+{
+const char kHexDigits[] = "0123456789abcdef";
+
+int countDigits(uint64_t value)
+{
+    int n = 1;
+    for (;;)
+    {
+        if (value < 10)
+            return n;
+        if (value < 100)
+            return n + 1;
+        if (value < 1000)
+            return n + 2;
+        if (value < 10000)
+            return n + 3;
+        value /= 10000;
+        n += 4;
+    }
+}
+} // namespace
+
+// 先算出位数，再从低位往高位每次写两位，不需要再反转
+int formatDecimal(char *buf, uint64_t value)
+{
+    int length = countDigits(value);
+    char *p = buf + length;
+    while (value >= 100)
+    {
+        p -= 2;
+        write2(p, static_cast<int>(value % 100));
+        value /= 100;
+    }
+    if (value >= 10)
+        write2(p - 2, static_cast<int>(value));
+    else
+        *(p - 1) = static_cast<char>('0' + value);
+    return length;
+}
+
+int formatHex(char *buf, uint64_t value)
+{
+    int length = value == 0 ? 1 : (64 - __builtin_clzll(value) + 3) / 4;
+    for (char *p = buf + length; p != buf; value >>= 4)
+        *--p = kHexDigits[value & 0xf];
+    return length;
+}
+} // namespace detail
 
 template <typename T>
 void LogStream::formatInteger(T num)
 {
     if (buffer_.avail() >= kMaxNumberSize)
     {
-        char *start = buffer_.current();
-        char *cur = start;
-        static const char *zero = digits + 9;
-        bool negative = (num < 0); // 判断num是否为负数
-        do
-        {
-            int remainder = static_cast<int>(num % 10);
-            (*cur++) = zero[remainder];
-            num /= 10;
-        } while (num != 0);
-        if (negative)
+        using Unsigned = typename std::make_unsigned<T>::type;
+        char *cur = buffer_.current();
+        Unsigned value = static_cast<Unsigned>(num);
+        if (num < 0)
         {
             *cur++ = '-';
+            value = static_cast<Unsigned>(0 - value); // 对最小的负数也成立
         }
-        *cur = '\0';
-        std::reverse(start, cur);
-        int length = static_cast<int>(cur - start);
-        buffer_.add(length);
+        cur += detail::formatDecimal(cur, value);
+        buffer_.add(cur - buffer_.current());
     }
 }
+
+template <typename T>
+void LogStream::formatFloat(T num)
+{
+    if (buffer_.avail() >= kMaxNumberSize)
+    {
+        // 最长的double最短表示是24个字符（例如-2.2250738585072014e-308），不会超出kMaxNumberSize
+        std::to_chars_result result = std::to_chars(buffer_.current(), buffer_.current() + kMaxNumberSize, num);
+        buffer_.add(result.ptr - buffer_.current());
+    }
+}
+
 // 重载输出流运算符<<，用于将布尔值写入缓冲区
 LogStream &LogStream::operator<<(bool express) {
     buffer_.append(express ? "true" : "false", express ? 4 : 5);
@@ -84,15 +142,13 @@ LogStream &LogStream::operator<<(unsigned long long number) {
 
 // 重载输出流运算符<<，用于将浮点数写入缓冲区
 LogStream &LogStream::operator<<(float number) {
-    *this<<static_cast<double>(number);
+    formatFloat(number);
     return *this;
 }
 
 // 重载输出流运算符<<，用于将双精度浮点数写入缓冲区
 LogStream &LogStream::operator<<(double number) {
-    char buffer[32];
-    snprintf(buffer, sizeof(buffer), "%.12g", number);
-    buffer_.append(buffer, strlen(buffer));
+    formatFloat(number);
     return *this;
 }
 
@@ -124,4 +180,61 @@ LogStream& LogStream::operator<<(const GeneralTemplate& g)
 {
     buffer_.append(g.data_, g.len_);
     return *this;
-}
\ No newline at end of file
+}
+
+LogStream &LogStream::operator<<(const void *p)
+{
+    if (buffer_.avail() >= kMaxNumberSize)
+    {
+        char *cur = buffer_.current();
+        cur[0] = '0';
+        cur[1] = 'x';
+        int length = detail::formatHex(cur + 2, reinterpret_cast<uintptr_t>(p));
+        buffer_.add(length + 2);
+    }
+    return *this;
+}
+
+LogStream &LogStream::operator<<(const Hex &hex)
+{
+    if (buffer_.avail() >= static_cast<size_t>(kMaxNumberSize) * 2)
+    {
+        char digits[kMaxNumberSize];
+        int length = detail::formatHex(digits, hex.value_);
+        int fill = std::min(hex.width_, kMaxNumberSize) - length;
+        if (fill < 0)
+            fill = 0;
+        char *out = buffer_.current();
+        memset(out, '0', fill);
+        memcpy(out + fill, digits, length);
+        buffer_.add(fill + length);
+    }
+    return *this;
+}
+
+LogStream &LogStream::operator<<(const Padded &padded)
+{
+    if (buffer_.avail() >= static_cast<size_t>(kMaxNumberSize) * 2)
+    {
+        bool negative = padded.value_ < 0;
+        uint64_t value = static_cast<uint64_t>(padded.value_);
+        if (negative)
+            value = 0 - value;
+        char digits[kMaxNumberSize];
+        int length = detail::formatDecimal(digits, value);
+        int fill = std::min(padded.width_, kMaxNumberSize) - length - (negative ? 1 : 0);
+        if (fill < 0)
+            fill = 0;
+        char *out = buffer_.current();
+        // 补0时负号放在最前面：-0042
+        if (negative && padded.fill_ == '0')
+            *out++ = '-';
+        memset(out, padded.fill_, fill);
+        out += fill;
+        if (negative && padded.fill_ != '0')
+            *out++ = '-';
+        memcpy(out, digits, length);
+        buffer_.add(out + length - buffer_.current());
+    }
+    return *this;
+}
@@ -1,8 +1,26 @@
 #pragma once
+#include <stdint.h>
 #include <string.h>
 #include <string>
 #include "noncopyable.h"
 #include "FixedBuffer.h"
+
+namespace detail
+{
+// "00".."99"，整数每次处理两位，查表写出
+extern const char kDigitPairs[201];
+
+// 定宽写两位十进制数字，0 <= n < 100
+inline void write2(char *p, int n)
+{
+    memcpy(p, kDigitPairs + n * 2, 2);
+}
+
+// 十进制/十六进制（小写、无前缀）写出value，返回长度；buf至少20字节
+int formatDecimal(char *buf, uint64_t value);
+int formatHex(char *buf, uint64_t value);
+} // namespace detail
+
 class GeneralTemplate : noncopyable
 {
 public:
@@ -19,6 +37,34 @@ public:
     const char* data_;
     int len_;
 };
+// 十六进制输出（小写、无0x前缀），不足width位时前面补0
+class Hex
+{
+public:
+    explicit Hex(uint64_t value, int width = 0)
+        : value_(value),
+          width_(width)
+    {}
+
+    uint64_t value_;
+    int width_;
+};
+
+// 定宽的十进制整数，不足width个字符时前面用fill填充（右对齐），例如Padded(fd, 5)、Padded(n, 8, '0')
+class Padded
+{
+public:
+    Padded(int64_t value, int width, char fill = ' ')
+        : value_(value),
+          width_(width),
+          fill_(fill)
+    {}
+
+    int64_t value_;
+    int width_;
+    char fill_;
+};
+
 // LogStream类用于管理日志输出流，重载输出流运算符<<，将各种类型的值写入内部缓冲区
 class LogStream : noncopyable
 {
@@ -79,6 +125,10 @@ public:
     LogStream &operator<<(const std::string &);
     // (const char*, int)的重载
     LogStream& operator<<(const GeneralTemplate& g);
+    // 指针按0x开头的十六进制输出（没有这个重载时对象指针会被转换成bool）
+    LogStream &operator<<(const void *);
+    LogStream &operator<<(const Hex &);
+    LogStream &operator<<(const Padded &);
 private:
     // 定义最大数字大小常量
     static constexpr int kMaxNumberSize = 32;
@@ -86,6 +136,9 @@ private:
     // 对于整型需要特殊的处理，模板函数用于格式化整型
     template <typename T>
     void formatInteger(T num);
+    // 浮点数用std::to_chars输出能精确还原的最短表示
+    template <typename T>
+    void formatFloat(T num);
 
     // 内部缓冲区对象
     Buffer buffer_;
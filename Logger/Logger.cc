@@ -1,12 +1,107 @@
 #include "Logger.h"
+#include "FlightRecorder.h"
 
 namespace ThreadInfo
 {
     thread_local char t_errnobuf[512]; // 每个线程独立的错误信息缓冲
-    thread_local char t_timer[64];     // 每个线程独立的时间格式化缓冲区
+    thread_local char t_timer[64];     // 每个线程独立的时间格式化缓冲区，"YYYY/MM/DD HH:MM:SS"
     thread_local time_t t_lastSecond;  // 每个线程记录上次格式化的时间
+    thread_local time_t t_lastMinute;  // t_timer对应的本地时间分钟数，同一分钟内只需要改写秒
+    thread_local long t_gmtOffset;     // 缓存的时区偏移（秒）
+    thread_local time_t t_offsetUntil; // 缓存的时区偏移在此之前有效：一小时之后，或者这一小时内的下一次时区切换
 
 }
+
+namespace
+{
+using detail::write2;
+
+// 1970-01-01以来的天数换算成公历年月日（Howard Hinnant的civil_from_days）
+void civilFromDays(int64_t days, int *year, int *month, int *day)
+{
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const int64_t doe = days - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    *day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    *month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    *year = static_cast<int>(yoe + era * 400 + (*month <= 2));
+}
+} // namespace
+
+// 同一秒内直接复用上次格式化的"YYYY/MM/DD HH:MM:SS"，同一分钟内只改写秒；
+// 时区偏移每小时用localtime_r（可重入，不像localtime那样每次都检查时区文件）取一次，其余时间自己换算
+void detail::formatLogTime(Timestamp time, char *out)
+{
+    using namespace ThreadInfo;
+    int64_t microSecondsSinceEpoch = time.microSecondsSinceEpoch();
+    time_t seconds = static_cast<time_t>(microSecondsSinceEpoch / Timestamp::kMicroSecondsPerSecond);
+    int microseconds = static_cast<int>(microSecondsSinceEpoch % Timestamp::kMicroSecondsPerSecond);
+
+    if (seconds != t_lastSecond)
+    {
+        if (seconds >= t_offsetUntil || seconds < t_lastSecond)
+        {
+            struct tm tm_time;
+            localtime_r(&seconds, &tm_time);
+            t_gmtOffset = tm_time.tm_gmtoff;
+            // 一小时之后的偏移不同，说明这一小时内有切换（不一定在整点，比如America/St_Johns曾在00:01切换），
+            // 二分找到切换的那一秒，缓存到那时为止
+            time_t until = seconds + 3600;
+            localtime_r(&until, &tm_time);
+            if (tm_time.tm_gmtoff != t_gmtOffset)
+            {
+                time_t unchanged = seconds;
+                while (until - unchanged > 1)
+                {
+                    time_t mid = unchanged + (until - unchanged) / 2;
+                    localtime_r(&mid, &tm_time);
+                    if (tm_time.tm_gmtoff == t_gmtOffset)
+                        unchanged = mid;
+                    else
+                        until = mid;
+                }
+            }
+            t_offsetUntil = until;
+            t_lastMinute = -1;
+        }
+        int64_t local = static_cast<int64_t>(seconds) + t_gmtOffset;
+        int64_t days = local / 86400;
+        int secondOfDay = static_cast<int>(local % 86400);
+        int64_t minute = local / 60;
+        if (minute != t_lastMinute)
+        {
+            int year, month, day;
+            civilFromDays(days, &year, &month, &day);
+            write2(t_timer, year / 100);
+            write2(t_timer + 2, year % 100);
+            t_timer[4] = '/';
+            write2(t_timer + 5, month);
+            t_timer[7] = '/';
+            write2(t_timer + 8, day);
+            t_timer[10] = ' ';
+            write2(t_timer + 11, secondOfDay / 3600);
+            t_timer[13] = ':';
+            write2(t_timer + 14, secondOfDay / 60 % 60);
+            t_timer[16] = ':';
+            t_lastMinute = minute;
+        }
+        write2(t_timer + 17, secondOfDay % 60);
+        // 更新最后一次时间调用
+        t_lastSecond = seconds;
+    }
+
+    memcpy(out, t_timer, 19);
+    // 微秒部分定宽6位：".uuuuuu "
+    out[19] = '.';
+    write2(out + 20, microseconds / 10000);
+    write2(out + 22, microseconds / 100 % 100);
+    write2(out + 24, microseconds % 100);
+    out[26] = ' ';
+}
+
 const char *getErrnoMsg(int savedErrno)
 {
     return strerror_r(savedErrno, ThreadInfo::t_errnobuf, sizeof(ThreadInfo::t_errnobuf));
@@ -42,6 +137,8 @@ static void defaultFlush()
 }
 Logger::OutputFunc g_output = defaultOutput;
 Logger::FlushFunc g_flush = defaultFlush;
+FlightRecorder *g_flightRecorder = nullptr;
+Logger::LogLevel g_outputLevel = Logger::TRACE; // 低于它的日志只写飞行记录器
 Logger::LogLevel Logger::g_logLevel = Logger::INFO;
 
 Logger::Impl::Impl(Logger::LogLevel level, int savedErrno, const char *filename, int line)
@@ -63,29 +160,9 @@ Logger::Impl::Impl(Logger::LogLevel level, int savedErrno, const char *filename,
 // 根据时区格式化当前时间字符串, 也是一条log消息的开头
 void Logger::Impl::formatTime()
 {
-    Timestamp now = Timestamp::now();
-    //计算秒数
-    time_t seconds = static_cast<time_t>(now.microSecondsSinceEpoch() / Timestamp::kMicroSecondsPerSecond);
-    int microseconds = static_cast<int>(now.microSecondsSinceEpoch() % Timestamp::kMicroSecondsPerSecond);
-    //计算剩余微秒数
-    struct tm *tm_timer = localtime(&seconds);
-    // 写入此线程存储的时间buf中
-    snprintf(ThreadInfo::t_timer, sizeof(ThreadInfo::t_timer), "%4d/%02d/%02d %02d:%02d:%02d",
-             tm_timer->tm_year + 1900,
-             tm_timer->tm_mon + 1,
-             tm_timer->tm_mday,
-             tm_timer->tm_hour,
-             tm_timer->tm_min,
-             tm_timer->tm_sec);
-    // 更新最后一次时间调用
-    ThreadInfo::t_lastSecond = seconds;
-
-    // muduo使用Fmt格式化整数，这里我们直接写入buf
-    char buf[32] = {0};
-    snprintf(buf, sizeof(buf), ".%06d ", microseconds);
-
-    
-    stream_ << GeneralTemplate(ThreadInfo::t_timer, 19) << GeneralTemplate(buf, 8);
+    char buf[detail::kLogTimeLength];
+    detail::formatLogTime(time_, buf);
+    stream_ << GeneralTemplate(buf, detail::kLogTimeLength);
 }
 void Logger::Impl::finish()
 {
@@ -99,8 +176,16 @@ Logger::~Logger()
 {
     impl_.finish();
     const LogStream::Buffer &buffer = stream().buffer();
+    // 先写飞行记录器，FATAL或者输出函数中崩溃时这一条也不会丢
+    if (g_flightRecorder)
+    {
+        g_flightRecorder->append(buffer.data(), buffer.length());
+    }
     // 输出(默认项终端输出)
-    g_output(buffer.data(), buffer.length());
+    if (impl_.level_ >= g_outputLevel)
+    {
+        g_output(buffer.data(), buffer.length());
+    }
     // FATAL情况终止程序
     if (impl_.level_ == FATAL)
     {
@@ -114,6 +199,12 @@ void Logger::setOutput(OutputFunc out)
     g_output = out;
 }
 
+void Logger::setFlightRecorder(FlightRecorder *recorder, LogLevel outputLevel)
+{
+    g_flightRecorder = recorder;
+    g_outputLevel = recorder ? outputLevel : TRACE;
+}
+
 void Logger::setFlush(FlushFunc flush)
 {
     g_flush = flush;
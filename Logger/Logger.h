@@ -11,6 +11,8 @@
 
 #define OPEN_LOGGING
 
+class FlightRecorder;
+
 // SourceFile的作用是提取文件名
 class SourceFile
 {
@@ -61,6 +63,9 @@ public:
     using FlushFunc = std::function<void()>;
     static void setOutput(OutputFunc);
     static void setFlush(FlushFunc);
+    // 每条日志同时写入飞行记录器（见FlightRecorder.h），低于outputLevel的只写飞行记录器、不交给OutputFunc，
+    // 这样可以常开DEBUG而正式的日志文件只有INFO以上。传nullptr取消
+    static void setFlightRecorder(FlightRecorder *recorder, LogLevel outputLevel = TRACE);
 
 private:
     class Impl
@@ -83,45 +88,62 @@ private:
 
 // 获取errno信息
 const char* getErrnoMsg(int savedErrno);
+
+namespace detail
+{
+const int kLogTimeLength = 27;
+// 按本地时区把time格式化为每条日志开头的"YYYY/MM/DD HH:MM:SS.uuuuuu "，写入out的kLogTimeLength字节（不以'\0'结尾）。
+// 结果缓存在线程局部变量中，进程运行期间不能修改TZ
+void formatLogTime(Timestamp time, char *out);
+} // namespace detail
+/**
+ * 编译期的最低日志等级（CMake选项LOG_MIN_LEVEL，默认TRACE即0）
+ * 低于它的LOG_*语句条件是编译期常量，整条语句连同参数的求值都被编译器删掉；
+ * 运行时Logger::setLogLevel仍然可以在它之上进一步过滤
+ */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
 /**
  * 当日志等级小于对应等级才会输出
  * 比如设置等级为FATAL，则logLevel等级大于DEBUG和INFO，DEBUG和INFO等级的日志就不会输出
  */
 #ifdef OPEN_LOGGING
-#define LOG_TRACE                                           \
-    if (Logger::TRACE < Logger::logLevel())                 \
-        ;                                                   \
-    else                                                    \
+#define LOG_TRACE                                                            \
+    if (Logger::TRACE < LOG_MIN_LEVEL || Logger::TRACE < Logger::logLevel()) \
+        ;                                                                    \
+    else                                                                     \
         Logger(__FILE__, __LINE__, Logger::TRACE).stream()
 
-#define LOG_DEBUG                                           \
-    if (Logger::DEBUG < Logger::logLevel())                 \
-        ;                                                   \
-    else                                                    \
+#define LOG_DEBUG                                                            \
+    if (Logger::DEBUG < LOG_MIN_LEVEL || Logger::DEBUG < Logger::logLevel()) \
+        ;                                                                    \
+    else                                                                     \
         Logger(__FILE__, __LINE__, Logger::DEBUG).stream()
 
-#define LOG_INFO                                            \
-    if (Logger::INFO < Logger::logLevel())                  \
-        ;                                                   \
-    else                                                    \
+#define LOG_INFO                                                           \
+    if (Logger::INFO < LOG_MIN_LEVEL || Logger::INFO < Logger::logLevel()) \
+        ;                                                                  \
+    else                                                                   \
         Logger(__FILE__, __LINE__, Logger::INFO).stream()
 
-#define LOG_WARN                                            \
-    if (Logger::WARN < Logger::logLevel())                  \
-        ;                                                   \
-    else                                                    \
+#define LOG_WARN                                                           \
+    if (Logger::WARN < LOG_MIN_LEVEL || Logger::WARN < Logger::logLevel()) \
+        ;                                                                  \
+    else                                                                   \
         Logger(__FILE__, __LINE__, Logger::WARN).stream()
 
-#define LOG_ERROR                                           \
-    if (Logger::ERROR < Logger::logLevel())                 \
-        ;                                                   \
-    else                                                    \
+#define LOG_ERROR                                                            \
+    if (Logger::ERROR < LOG_MIN_LEVEL || Logger::ERROR < Logger::logLevel()) \
+        ;                                                                    \
+    else                                                                     \
         Logger(__FILE__, __LINE__, Logger::ERROR).stream()
 
-#define LOG_FATAL                                           \
-    if (Logger::FATAL < Logger::logLevel())                 \
-        ;                                                   \
-    else                                                    \
+#define LOG_FATAL                                                            \
+    if (Logger::FATAL < LOG_MIN_LEVEL || Logger::FATAL < Logger::logLevel()) \
+        ;                                                                    \
+    else                                                                     \
         Logger(__FILE__, __LINE__, Logger::FATAL).stream()
 #else
 #define LOG(level) LogStream()
@@ -0,0 +1,128 @@
+#include "FlightRecorder.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+
+// 把FlightRecorder的环形文件按写入顺序还原成文本：./flightdecoder file
+// 进程崩溃之后也可以解码，写了一半或者被下一圈覆盖的记录会被跳过
+namespace
+{
+
+class Ring
+{
+public:
+    Ring(const char *data, uint64_t capacity) : data_(data), capacity_(capacity) {}
+
+    void copyOut(uint64_t pos, void *out, size_t len) const
+    {
+        size_t offset = static_cast<size_t>(pos & (capacity_ - 1));
+        size_t first = static_cast<size_t>(capacity_) - offset;
+        if (len <= first)
+        {
+            memcpy(out, data_ + offset, len);
+        }
+        else
+        {
+            memcpy(out, data_ + offset, first);
+            memcpy(static_cast<char *>(out) + first, data_, len - first);
+        }
+    }
+
+    // pos处是一条完整的记录时返回内容长度，否则返回-1
+    int64_t recordAt(uint64_t pos, uint64_t head) const
+    {
+        uint64_t stored;
+        uint32_t len;
+        copyOut(pos, &stored, sizeof stored);
+        copyOut(pos + sizeof stored, &len, sizeof len);
+        if (stored != pos || len == 0 || len > capacity_ / 4 || pos + FlightRecorder::recordSize(len) > head)
+            return -1;
+        return len;
+    }
+
+private:
+    const char *data_;
+    uint64_t capacity_;
+};
+
+bool decodeFile(const char *filename)
+{
+    int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || ::fstat(fd, &st) != 0)
+    {
+        perror(filename);
+        return false;
+    }
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    void *addr = fileSize >= sizeof(FlightRecorderHeader)
+                     ? ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0)
+                     : MAP_FAILED;
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        fprintf(stderr, "flightdecoder: %s: cannot map file\n", filename);
+        return false;
+    }
+
+    const FlightRecorderHeader *header = static_cast<const FlightRecorderHeader *>(addr);
+    uint64_t capacity = header->capacity;
+    if (memcmp(header->magic, "FLIGHTR1", 8) != 0 || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        header->dataOffset + capacity > fileSize)
+    {
+        fprintf(stderr, "flightdecoder: %s: not a flight recorder file\n", filename);
+        ::munmap(addr, fileSize);
+        return false;
+    }
+
+    Ring ring(static_cast<const char *>(addr) + header->dataOffset, capacity);
+    const uint64_t head = header->head.load(std::memory_order_acquire);
+    // 最多只有最后一圈还在环里，位置从capacity开始编号
+    uint64_t pos = head > 2 * capacity ? head - capacity : capacity;
+    uint64_t records = 0;
+    uint64_t skipped = 0;
+    std::string line;
+    while (pos + sizeof(FlightRecord) <= head)
+    {
+        int64_t len = ring.recordAt(pos, head);
+        if (len < 0)
+        {
+            // 不是记录的开头（最早的一条被覆盖了一半）或者写了一半，按8字节往后找下一条
+            pos += 8;
+            skipped += 8;
+            continue;
+        }
+        line.resize(static_cast<size_t>(len));
+        ring.copyOut(pos + sizeof(FlightRecord), &line[0], line.size());
+        if (line.back() != '\n')
+            line.push_back('\n');
+        ::fwrite(line.data(), 1, line.size(), stdout);
+        pos += FlightRecorder::recordSize(static_cast<uint32_t>(len));
+        ++records;
+    }
+    fprintf(stderr, "flightdecoder: %s: pid %d, capacity %" PRIu64 ", %" PRIu64 " records, %" PRIu64
+            " bytes skipped\n", filename, header->pid, capacity, records, skipped);
+    ::munmap(addr, fileSize);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s flight_recorder_file...\n", argv[0]);
+        return 1;
+    }
+    bool ok = true;
+    for (int i = 1; i < argc; ++i)
+        ok = decodeFile(argv[i]) && ok;
+    return ok ? 0 : 1;
+}
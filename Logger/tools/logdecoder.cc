@@ -0,0 +1,287 @@
+#include "BinaryLog.h"
+
+#include <charconv>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <unordered_map>
+
+// 把LOG_BIN_*写出的二进制日志文件还原成文本：./logdecoder file...
+// 每个文件先扫一遍收集调用点定义，再解码：多线程写时定义可能排在第一次使用它的记录之后。
+// 用AsyncLogging::setFileHeader(BinaryLog::siteTable)写的文件开头带有全部定义，可以单独解码；
+// 否则按时间顺序把之前的文件一起传进来，前面文件中的定义对后面的文件仍然有效
+namespace
+{
+
+struct Site
+{
+    int level;
+    uint32_t line;
+    std::string file;
+    std::string format;
+    std::string types;
+};
+
+const char *kLevelNames[Logger::LEVEL_COUNT] = {
+    "TRACE ", "DEBUG ", "INFO  ", "WARN  ", "ERROR ", "FATAL ",
+};
+
+std::unordered_map<uint32_t, Site> g_sites;
+
+// 按顺序读取一条记录中的字段，越界后一直返回false
+class Reader
+{
+public:
+    Reader(const char *data, size_t len) : cur_(data), end_(data + len) {}
+
+    template <typename T>
+    bool read(T *value)
+    {
+        if (static_cast<size_t>(end_ - cur_) < sizeof(T))
+        {
+            cur_ = end_;
+            return false;
+        }
+        memcpy(value, cur_, sizeof(T));
+        cur_ += sizeof(T);
+        return true;
+    }
+
+    bool readString(std::string *str)
+    {
+        uint16_t len;
+        if (!read(&len) || static_cast<size_t>(end_ - cur_) < len)
+        {
+            cur_ = end_;
+            return false;
+        }
+        str->assign(cur_, len);
+        cur_ += len;
+        return true;
+    }
+
+private:
+    const char *cur_;
+    const char *end_;
+};
+
+void formatTime(int64_t microSecondsSinceEpoch, std::string *out)
+{
+    time_t seconds = static_cast<time_t>(microSecondsSinceEpoch / Timestamp::kMicroSecondsPerSecond);
+    int microseconds = static_cast<int>(microSecondsSinceEpoch % Timestamp::kMicroSecondsPerSecond);
+    struct tm tm_time;
+    localtime_r(&seconds, &tm_time);
+    char buf[64];
+    snprintf(buf, sizeof buf, "%4d/%02d/%02d %02d:%02d:%02d.%06d ", tm_time.tm_year + 1900, tm_time.tm_mon + 1,
+             tm_time.tm_mday, tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec, microseconds);
+    out->append(buf);
+}
+
+// 按类型读一个参数并追加到out
+void formatArg(char type, Reader &reader, std::string *out)
+{
+    char buf[64];
+    switch (type)
+    {
+    case BinaryLogType::kInt:
+    {
+        int64_t v;
+        if (!reader.read(&v))
+            break;
+        snprintf(buf, sizeof buf, "%" PRId64, v);
+        out->append(buf);
+        return;
+    }
+    case BinaryLogType::kUint:
+    {
+        uint64_t v;
+        if (!reader.read(&v))
+            break;
+        snprintf(buf, sizeof buf, "%" PRIu64, v);
+        out->append(buf);
+        return;
+    }
+    case BinaryLogType::kDouble:
+    {
+        double v;
+        if (!reader.read(&v))
+            break;
+        // 和LogStream的文本格式一致：能精确还原的最短表示
+        std::to_chars_result result = std::to_chars(buf, buf + sizeof buf, v);
+        out->append(buf, result.ptr - buf);
+        return;
+    }
+    case BinaryLogType::kChar:
+    {
+        char v;
+        if (!reader.read(&v))
+            break;
+        out->push_back(v);
+        return;
+    }
+    case BinaryLogType::kBool:
+    {
+        uint8_t v;
+        if (!reader.read(&v))
+            break;
+        out->append(v ? "true" : "false");
+        return;
+    }
+    case BinaryLogType::kPointer:
+    {
+        uint64_t v;
+        if (!reader.read(&v))
+            break;
+        snprintf(buf, sizeof buf, "0x%" PRIx64, v);
+        out->append(buf);
+        return;
+    }
+    case BinaryLogType::kString:
+    {
+        std::string s;
+        if (!reader.readString(&s))
+            break;
+        out->append(s);
+        return;
+    }
+    default:
+        break;
+    }
+    // 记录被截断或者类型未知
+    out->append("<?>");
+}
+
+void defineSite(const BinaryLogRecord &header, Reader &reader)
+{
+    uint32_t id;
+    uint8_t level;
+    Site site;
+    if (!reader.read(&id) || !reader.read(&level) || !reader.read(&site.line) || !reader.readString(&site.file) ||
+        !reader.readString(&site.format) || !reader.readString(&site.types))
+    {
+        fprintf(stderr, "logdecoder: bad site definition at time %" PRId64 "\n", header.time);
+        return;
+    }
+    site.level = level < Logger::LEVEL_COUNT ? level : static_cast<int>(Logger::INFO);
+    g_sites[id] = std::move(site);
+}
+
+void decodeRecord(const BinaryLogRecord &header, Reader &reader, std::string *line)
+{
+    line->clear();
+    formatTime(header.time, line);
+    auto it = g_sites.find(header.siteId);
+    if (it == g_sites.end())
+    {
+        char buf[64];
+        snprintf(buf, sizeof buf, "?????? <unknown site %u, %u bytes>\n", header.siteId, header.size);
+        line->append(buf);
+        return;
+    }
+    const Site &site = it->second;
+    line->append(kLevelNames[site.level]);
+
+    // 用参数依次替换格式串中的{}，多出来的参数用空格隔开追加在后面
+    size_t arg = 0;
+    const std::string &format = site.format;
+    for (size_t i = 0; i < format.size(); ++i)
+    {
+        if (format[i] == '{' && i + 1 < format.size() && format[i + 1] == '}' && arg < site.types.size())
+        {
+            formatArg(site.types[arg++], reader, line);
+            ++i;
+        }
+        else
+        {
+            line->push_back(format[i]);
+        }
+    }
+    for (; arg < site.types.size(); ++arg)
+    {
+        line->push_back(' ');
+        formatArg(site.types[arg], reader, line);
+    }
+
+    char buf[32];
+    snprintf(buf, sizeof buf, ":%u\n", site.line);
+    line->append(" - ");
+    line->append(site.file.substr(site.file.rfind('/') + 1));
+    line->append(buf);
+}
+
+// 依次对文件中的每条记录调用func(header, reader)，文件损坏时返回false，quiet为false时打印原因
+template <typename Func>
+bool forEachRecord(FILE *fp, const char *filename, bool quiet, Func &&func)
+{
+    std::string record;
+    BinaryLogRecord header;
+    while (::fread(&header, sizeof header, 1, fp) == 1)
+    {
+        if (header.size < sizeof header || header.size > static_cast<uint32_t>(BinaryLog::kMaxRecordSize))
+        {
+            // LogFile预分配或者进程崩溃留下的空洞/残缺记录，后面的内容无法对齐
+            if (header.size != 0)
+            {
+                if (!quiet)
+                    fprintf(stderr, "logdecoder: %s: bad record size %u, stop\n", filename, header.size);
+                return false;
+            }
+            return true;
+        }
+        record.resize(header.size - sizeof header);
+        if (!record.empty() && ::fread(&record[0], record.size(), 1, fp) != 1)
+        {
+            if (!quiet)
+                fprintf(stderr, "logdecoder: %s: truncated record\n", filename);
+            return false;
+        }
+        Reader reader(record.data(), record.size());
+        func(header, reader);
+    }
+    return true;
+}
+
+bool decodeFile(const char *filename)
+{
+    FILE *fp = ::fopen(filename, "rb");
+    if (fp == nullptr)
+    {
+        perror(filename);
+        return false;
+    }
+
+    // 第一遍只收集定义，错误留到第二遍报告
+    forEachRecord(fp, filename, true, [](const BinaryLogRecord &header, Reader &reader) {
+        if (header.siteId == 0)
+            defineSite(header, reader);
+    });
+    ::rewind(fp);
+
+    std::string line;
+    bool ok = forEachRecord(fp, filename, false, [&line](const BinaryLogRecord &header, Reader &reader) {
+        if (header.siteId != 0)
+        {
+            decodeRecord(header, reader, &line);
+            ::fwrite(line.data(), 1, line.size(), stdout);
+        }
+    });
+    ::fclose(fp);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s binary_log_file...\n", argv[0]);
+        return 1;
+    }
+    bool ok = true;
+    for (int i = 1; i < argc; ++i)
+        ok = decodeFile(argv[i]) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include <ChainBuffer.h>
+
+ChainBuffer::ChainBuffer()
+    : readableBytes_(0),
+      zeroCopyThreshold_(0),
+      zeroCopySeq_(0),
+      zeroCopyPendingBytes_(0),
+      zeroCopyCopied_(0)
+{
+}
+
+ChainBuffer::~ChainBuffer()
+{
+    retrieveAll(); // 关闭尚未发送完的文件段
+}
+
+void ChainBuffer::append(const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        if (chunks_.empty() || chunks_.back().writableBytes() == 0)
+        {
+            appendBlock();
+        }
+        Chunk &tail = chunks_.back();
+        size_t n = std::min(len, tail.writableBytes());
+        std::copy(data, data + n, &tail.data[tail.writeIndex]);
+        tail.writeIndex += n;
+        readableBytes_ += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void ChainBuffer::append(std::string &&data)
+{
+    bool zeroCopy = zeroCopyThreshold_ > 0 && data.size() >= zeroCopyThreshold_;
+    if (data.size() < kBlockSize && !zeroCopy)
+    {
+        append(data.data(), data.size());
+        return;
+    }
+    // slice的writableBytes()为0，后续追加的数据会落到新块里，保证顺序
+    size_t len = data.size();
+    chunks_.push_back(Chunk{std::move(data), 0, len, -1, 0, zeroCopy, false, 0});
+    readableBytes_ += len;
+}
+
+void ChainBuffer::appendFile(int fd, off_t offset, size_t len)
+{
+    if (len == 0)
+    {
+        ::close(fd);
+        return;
+    }
+    chunks_.push_back(Chunk{std::string(), 0, len, fd, offset, false, false, 0});
+    readableBytes_ += len;
+}
+
+void ChainBuffer::retrieve(size_t len)
+{
+    assert(len <= readableBytes_);
+    while (len > 0)
+    {
+        Chunk &head = chunks_.front();
+        size_t n = std::min(len, head.readableBytes());
+        head.readIndex += n;
+        readableBytes_ -= n;
+        len -= n;
+        if (head.readableBytes() == 0)
+        {
+            popFront();
+        }
+    }
+}
+
+void ChainBuffer::retrieveAll()
+{
+    while (!chunks_.empty())
+    {
+        popFront();
+    }
+    readableBytes_ = 0;
+}
+
+/**
+ * 一次writev最多提交IOV_MAX个分段，遇到文件段就停下，超过的部分等下一次可写事件再发。
+ * 链头就是文件段时单独调用一次sendfile。
+ * 返回值语义和Buffer::writeFd保持一致：n < 0 时 *saveErrno 中保存错误码。
+ */
+ssize_t ChainBuffer::writeFd(int fd, int *saveErrno)
+{
+    while (!chunks_.empty() && chunks_.front().isFile())
+    {
+        Chunk &head = chunks_.front();
+        off_t offset = head.offset + static_cast<off_t>(head.readIndex);
+        ssize_t n = ::sendfile(fd, head.fd, &offset, head.readableBytes());
+        if (n < 0)
+        {
+            *saveErrno = errno;
+        }
+        if (n != 0)
+        {
+            return n;
+        }
+        // 文件比声明的长度短(被截断)，丢弃这一段剩余的部分，继续发后面的数据
+        readableBytes_ -= head.readableBytes();
+        popFront();
+    }
+    if (!chunks_.empty() && chunks_.front().zeroCopy)
+    {
+        return writeZeroCopy(fd, chunks_.front(), saveErrno);
+    }
+
+    struct iovec vec[IOV_MAX];
+    int iovcnt = peekIovec(vec, IOV_MAX);
+    if (iovcnt == 0)
+    {
+        return 0;
+    }
+
+    ssize_t n = ::writev(fd, vec, iovcnt);
+    if (n < 0)
+    {
+        *saveErrno = errno;
+    }
+    return n;
+}
+
+int ChainBuffer::peekIovec(struct iovec *vec, int maxIov)
+{
+    int iovcnt = 0;
+    for (auto it = chunks_.begin(); it != chunks_.end() && iovcnt < maxIov; ++it)
+    {
+        if (it->isFile() || it->zeroCopy)
+        {
+            break; // 前面的内存数据发完之后，下一次再sendfile或者零拷贝发送
+        }
+        if (it->readableBytes() == 0)
+        {
+            continue; // 只可能是刚挂上还没写数据的尾块
+        }
+        vec[iovcnt].iov_base = &it->data[it->readIndex];
+        vec[iovcnt].iov_len = it->readableBytes();
+        ++iovcnt;
+    }
+    return iovcnt;
+}
+
+ssize_t ChainBuffer::writeZeroCopy(int fd, Chunk &head, int *saveErrno)
+{
+    struct iovec vec;
+    vec.iov_base = &head.data[head.readIndex];
+    vec.iov_len = head.readableBytes();
+    struct msghdr msg = {};
+    msg.msg_iov = &vec;
+    msg.msg_iovlen = 1;
+
+    ssize_t n = ::sendmsg(fd, &msg, MSG_ZEROCOPY);
+    if (n >= 0)
+    {
+        // 每一次成功（包括部分成功）的MSG_ZEROCOPY发送占用一个通知序号
+        head.zeroCopySent = true;
+        head.lastSeq = zeroCopySeq_++;
+    }
+    else if (errno == ENOBUFS)
+    {
+        // 超出 optmem 限制，这一次退化为普通拷贝发送
+        n = ::sendmsg(fd, &msg, 0);
+    }
+    if (n < 0)
+    {
+        *saveErrno = errno;
+    }
+    return n;
+}
+
+/**
+ * 完成通知 sock_extended_err 中 [ee_info, ee_data] 是一段连续的已完成序号。
+ * TCP按确认顺序完成，所以zeroCopyPending_从头开始释放即可。
+ */
+int ChainBuffer::handleZeroCopyCompletions(int fd, int *saveErrno)
+{
+    int count = 0;
+    for (;;)
+    {
+        char control[128];
+        struct msghdr msg = {};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (::recvmsg(fd, &msg, MSG_ERRQUEUE) < 0)
+        {
+            if (errno == EAGAIN)
+            {
+                return count;
+            }
+            *saveErrno = errno;
+            return -1;
+        }
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm))
+        {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+            {
+                continue;
+            }
+            const struct sock_extended_err *serr =
+                reinterpret_cast<const struct sock_extended_err *>(CMSG_DATA(cm));
+            if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+            {
+                continue;
+            }
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+            {
+                ++zeroCopyCopied_;
+            }
+            uint32_t hi = serr->ee_data;
+            while (!zeroCopyPending_.empty() &&
+                   static_cast<int32_t>(zeroCopyPending_.front().lastSeq - hi) <= 0)
+            {
+                zeroCopyPendingBytes_ -= zeroCopyPending_.front().data.size();
+                zeroCopyPending_.pop_front();
+            }
+            ++count;
+        }
+    }
+}
+
+void ChainBuffer::appendBlock()
+{
+    if (!freeBlocks_.empty())
+    {
+        chunks_.push_back(Chunk{std::move(freeBlocks_.back()), 0, 0, -1, 0, false, false, 0});
+        freeBlocks_.pop_back();
+    }
+    else
+    {
+        chunks_.push_back(Chunk{std::string(kBlockSize, '\0'), 0, 0, -1, 0, false, false, 0});
+    }
+}
+
+void ChainBuffer::popFront()
+{
+    Chunk &head = chunks_.front();
+    if (head.isFile())
+    {
+        ::close(head.fd);
+    }
+    else if (head.zeroCopySent)
+    {
+        // 内核可能还在引用这块内存，等完成通知后再释放
+        zeroCopyPendingBytes_ += head.data.size();
+        zeroCopyPending_.push_back(PendingSlice{std::move(head.data), head.lastSeq});
+    }
+    // 只回收固定大小的块，slice用完直接释放
+    else if (head.data.size() == kBlockSize && freeBlocks_.size() < kMaxFreeBlocks)
+    {
+        freeBlocks_.push_back(std::move(head.data));
+    }
+    chunks_.pop_front();
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <deque>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <sys/types.h>
+
+struct iovec;
+
+/**
+ * 发送方向使用的链式缓冲区
+ * | block(16K) | block(16K) | slice(大消息) | file(fd,offset,len) | block(16K) | ...
+ *
+ * 小消息拷贝进尾部的固定大小块，写满就在链尾挂一个新块；
+ * 不小于 kBlockSize 的消息以右值传入时直接接管 std::string 的内存（slice），不做拷贝。
+ * 发送时用 writev 一次提交最多 IOV_MAX 个分段，发送完的块回收到空闲链表，
+ * 因此积压再多也不会像 Buffer::makeSpace 那样整体搬移或者 resize。
+ * 文件段（file）按顺序排在内存数据之间，轮到它时用 sendfile 直接从页缓存发出。
+ * 打开零拷贝(setZeroCopyThreshold)后，不小于阈值的slice用 MSG_ZEROCOPY 发送，
+ * 发送完的slice暂存在 zeroCopyPending_ 中，直到从socket错误队列读到内核的完成通知才释放。
+ * retrieveAll同样把已经发出的slice转入 zeroCopyPending_；析构时它们随之释放，
+ * 所以析构前调用者要等 zeroCopyPendingBytes() 归零（见TcpConnection::lingerZeroCopy）。
+ */
+class ChainBuffer : noncopyable
+{
+public:
+    static const size_t kBlockSize = 16 * 1024;
+    static const size_t kMaxFreeBlocks = 4; // 空闲块最多缓存的个数，多余的直接释放
+
+    ChainBuffer();
+    ~ChainBuffer();
+
+    size_t readableBytes() const { return readableBytes_; }
+
+    // 把[data, data+len]内存上的数据拷贝到链尾
+    void append(const char *data, size_t len);
+    // 大消息直接挂到链尾，小消息仍然走拷贝
+    void append(std::string &&data);
+
+    // 追加一段文件数据 [offset, offset+len)，fd的所有权转交给ChainBuffer，发送完毕后关闭
+    void appendFile(int fd, off_t offset, size_t len);
+
+    void retrieve(size_t len);
+    void retrieveAll();
+
+    // 用writev把链表中的数据写到fd，链头是文件段时改用sendfile，链头是零拷贝slice时改用sendmsg(MSG_ZEROCOPY)
+    // 不移动读指针，由调用者根据返回值retrieve
+    ssize_t writeFd(int fd, int *saveErrno);
+    // 从链头开始取最多maxIov个连续的内存分段，遇到文件段或零拷贝slice停止，返回分段个数
+    // 分段内存在retrieve之前保持有效（之后的append不会移动它们），可以交给异步发送
+    int peekIovec(struct iovec *vec, int maxIov);
+
+    // 不小于threshold的右值消息走MSG_ZEROCOPY，0表示关闭。socket需要已经打开SO_ZEROCOPY
+    void setZeroCopyThreshold(size_t threshold) { zeroCopyThreshold_ = threshold; }
+    size_t zeroCopyThreshold() const { return zeroCopyThreshold_; }
+    // 读取socket错误队列中的零拷贝完成通知，释放内核已经用完的slice；返回处理的通知个数，出错返回-1
+    int handleZeroCopyCompletions(int fd, int *saveErrno);
+    // 等待内核完成通知的slice字节数
+    size_t zeroCopyPendingBytes() const { return zeroCopyPendingBytes_; }
+    // 内核退化为拷贝发送的次数（例如发往本机回环地址）
+    uint64_t zeroCopyCopiedCount() const { return zeroCopyCopied_; }
+
+private:
+    struct Chunk
+    {
+        std::string data; // 固定块时 data.size() == kBlockSize，slice时就是整条消息
+        size_t readIndex;
+        size_t writeIndex;
+        int fd;           // 文件段的fd，内存块为-1
+        off_t offset;     // 文件段在文件中的起始偏移
+        bool zeroCopy;    // 用MSG_ZEROCOPY发送的slice
+        bool zeroCopySent;
+        uint32_t lastSeq; // 最后一次零拷贝发送对应的内核通知序号
+
+        bool isFile() const { return fd >= 0; }
+        size_t readableBytes() const { return writeIndex - readIndex; }
+        size_t writableBytes() const { return isFile() ? 0 : data.size() - writeIndex; }
+    };
+
+    struct PendingSlice
+    {
+        std::string data;
+        uint32_t lastSeq;
+    };
+
+    void appendBlock();
+    void popFront();
+    ssize_t writeZeroCopy(int fd, Chunk &head, int *saveErrno);
+
+    std::deque<Chunk> chunks_;
+    std::vector<std::string> freeBlocks_;
+    size_t readableBytes_;
+
+    size_t zeroCopyThreshold_;
+    uint32_t zeroCopySeq_; // 下一次MSG_ZEROCOPY发送的序号，与内核计数保持一致
+    std::deque<PendingSlice> zeroCopyPending_;
+    size_t zeroCopyPendingBytes_;
+    uint64_t zeroCopyCopied_;
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature, size_t Capacity = 64>
+class InlineFunction;
+
+/**
+ * 只能移动的可调用对象，捕获列表不超过Capacity字节的lambda直接放在对象内部，不分配堆内存
+ * （std::function在libstdc++中只有16字节的内部空间，捕获一个std::string就要new）。
+ * 超过Capacity、对齐要求过高或者移动构造可能抛异常的可调用对象退回到堆上存放，行为仍然正确。
+ * 和std::function一样，operator()是const的，但可以调用mutable lambda。
+ */
+template <typename R, typename... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity>
+{
+    static_assert(Capacity >= sizeof(void *), "capacity must hold at least a pointer");
+
+public:
+    InlineFunction() noexcept : ops_(nullptr) {}
+    InlineFunction(std::nullptr_t) noexcept : ops_(nullptr) {}
+
+    template <typename F,
+              typename = typename std::enable_if<
+                  !std::is_same<typename std::decay<F>::type, InlineFunction>::value &&
+                  std::is_invocable_r<R, typename std::decay<F>::type &, Args...>::value>::type>
+    InlineFunction(F &&f) : ops_(nullptr)
+    {
+        using Fn = typename std::decay<F>::type;
+        if constexpr (isInline<Fn>())
+        {
+            ::new (static_cast<void *>(storage_)) Fn(std::forward<F>(f));
+            ops_ = &InlineOps<Fn>::ops;
+        }
+        else
+        {
+            *reinterpret_cast<Fn **>(storage_) = new Fn(std::forward<F>(f));
+            ops_ = &HeapOps<Fn>::ops;
+        }
+    }
+
+    InlineFunction(InlineFunction &&other) noexcept : ops_(other.ops_)
+    {
+        if (ops_ != nullptr)
+        {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    InlineFunction &operator=(InlineFunction &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            if (other.ops_ != nullptr)
+            {
+                ops_ = other.ops_;
+                ops_->move(storage_, other.storage_);
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InlineFunction &operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    InlineFunction(const InlineFunction &) = delete;
+    InlineFunction &operator=(const InlineFunction &) = delete;
+
+    ~InlineFunction() { reset(); }
+
+    R operator()(Args... args) const
+    {
+        return ops_->invoke(const_cast<unsigned char *>(storage_), std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    // 可调用对象是否放在内部存储中（没有堆分配）
+    template <typename Fn>
+    static constexpr bool isInline()
+    {
+        return sizeof(Fn) <= Capacity && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<Fn>::value;
+    }
+
+private:
+    struct Ops
+    {
+        R (*invoke)(void *storage, Args &&...args);
+        void (*move)(void *dst, void *src); // 移动到dst并析构src
+        void (*destroy)(void *storage);
+    };
+
+    template <typename Fn>
+    struct InlineOps
+    {
+        static R invoke(void *storage, Args &&...args)
+        {
+            return (*static_cast<Fn *>(storage))(std::forward<Args>(args)...);
+        }
+        static void move(void *dst, void *src)
+        {
+            Fn *from = static_cast<Fn *>(src);
+            ::new (dst) Fn(std::move(*from));
+            from->~Fn();
+        }
+        static void destroy(void *storage) { static_cast<Fn *>(storage)->~Fn(); }
+        static constexpr Ops ops = {&invoke, &move, &destroy};
+    };
+
+    template <typename Fn>
+    struct HeapOps
+    {
+        static R invoke(void *storage, Args &&...args)
+        {
+            return (**static_cast<Fn **>(storage))(std::forward<Args>(args)...);
+        }
+        static void move(void *dst, void *src)
+        {
+            *static_cast<Fn **>(dst) = *static_cast<Fn **>(src);
+        }
+        static void destroy(void *storage) { delete *static_cast<Fn **>(storage); }
+        static constexpr Ops ops = {&invoke, &move, &destroy};
+    };
+
+    void reset() noexcept
+    {
+        if (ops_ != nullptr)
+        {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[Capacity];
+    const Ops *ops_;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Timestamp.h"
+
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * 单调时钟（CLOCK_MONOTONIC）上的时间点，单位微秒，起点是系统启动时刻
+ * 不受系统时间被修改（NTP跳变、手动改时间）的影响，定时器都用它计时；
+ * 只能用来计算时间间隔，不能转换成日历时间，需要显示的时间仍然用Timestamp。
+ * clock_gettime在x86-64上通过vDSO完成，不陷入内核。
+ */
+class MonoTimestamp
+{
+public:
+    MonoTimestamp() : microSeconds_(0) {}
+    explicit MonoTimestamp(int64_t microSeconds) : microSeconds_(microSeconds) {}
+
+    static MonoTimestamp now()
+    {
+        struct timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return MonoTimestamp(static_cast<int64_t>(ts.tv_sec) * Timestamp::kMicroSecondsPerSecond + ts.tv_nsec / 1000);
+    }
+
+    // 把一个墙上时间换算成单调时钟上对应的时间点（按当前两个时钟的差值）
+    static MonoTimestamp fromTimestamp(Timestamp when)
+    {
+        return MonoTimestamp(now().microSeconds_ + when.microSecondsSinceEpoch() -
+                             Timestamp::now().microSecondsSinceEpoch());
+    }
+
+    int64_t microSeconds() const { return microSeconds_; }
+
+    bool valid() const { return microSeconds_ > 0; }
+    static MonoTimestamp invalid() { return MonoTimestamp(); }
+
+private:
+    int64_t microSeconds_;
+};
+
+inline bool operator<(MonoTimestamp lhs, MonoTimestamp rhs)
+{
+    return lhs.microSeconds() < rhs.microSeconds();
+}
+
+inline bool operator==(MonoTimestamp lhs, MonoTimestamp rhs)
+{
+    return lhs.microSeconds() == rhs.microSeconds();
+}
+
+inline bool operator!=(MonoTimestamp lhs, MonoTimestamp rhs)
+{
+    return lhs.microSeconds() != rhs.microSeconds();
+}
+
+inline MonoTimestamp addTime(MonoTimestamp timestamp, double seconds)
+{
+    int64_t delta = static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond);
+    return MonoTimestamp(timestamp.microSeconds() + delta);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ObjectPool.h"
+#include "noncopyable.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <utility>
+
+/**
+ * 无锁多生产者单消费者队列（Vyukov intrusive MPSC）
+ * 生产者：一次原子exchange把新节点挂到head_，再把前驱的next指向它，不需要CAS重试；
+ * 消费者：只有一个线程沿着tail_->next往后取，不需要同步。
+ * 队列中始终有一个哑节点，出队后的节点成为新的哑节点。
+ *
+ * 全局顺序以exchange的先后为准，同一生产者的元素保持入队顺序。
+ * 某个生产者exchange之后、链接next之前被调度走时，消费者暂时看不到它及其之后的元素，
+ * 这些元素会在下一次drain时取出（生产者入队后都会唤醒消费者，不会丢失）。
+ * 节点从ObjectPool中分配，出队后归还，稳定运行时push/drain都不分配内存。
+ */
+template <typename T>
+class MpscQueue : noncopyable
+{
+public:
+    MpscQueue()
+        : head_(pool_.create()), tail_(head_.load(std::memory_order_relaxed))
+    {
+    }
+
+    ~MpscQueue()
+    {
+        while (tail_ != nullptr)
+        {
+            Node *next = tail_->next.load(std::memory_order_relaxed);
+            pool_.destroy(tail_);
+            tail_ = next;
+        }
+    }
+
+    // 任意线程调用
+    void push(T value)
+    {
+        Node *node = pool_.create(std::move(value));
+        Node *prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 只能由消费者线程调用：依次处理调用开始时已经入队的元素，返回处理的个数
+    // 处理过程中新入队的元素（例如func里又push的）留到下一次，避免消费者一直停在这里
+    template <typename Func>
+    size_t drain(Func &&func)
+    {
+        Node *last = head_.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (tail_ != last)
+        {
+            Node *next = tail_->next.load(std::memory_order_acquire);
+            if (next == nullptr)
+                break; // 生产者还没有链接完成
+            T value(std::move(next->value));
+            pool_.destroy(tail_);
+            tail_ = next;
+            func(value);
+            ++count;
+        }
+        return count;
+    }
+
+    // 只能由消费者线程调用，结果只是一个瞬时值
+    bool empty() const { return tail_->next.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    struct Node
+    {
+        Node() : next(nullptr) {}
+        explicit Node(T &&v) : next(nullptr), value(std::move(v)) {}
+
+        std::atomic<Node *> next;
+        T value;
+    };
+
+    ObjectPool<Node> pool_; // 必须在head_之前构造
+    alignas(64) std::atomic<Node *> head_; // 生产者竞争的一端，和消费者的tail_分开在不同缓存行
+    alignas(64) Node *tail_;
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+/**
+ * 定长对象池，任意线程都可以create/destroy
+ * 空闲槽位组成一个无锁栈(Treiber stack)，栈顶是 (tag << 32 | index + 1)，
+ * 每次出栈/入栈tag加一，避免ABA问题；槽位按kChunkSize分块分配，分配后直到池析构才释放，
+ * 因此并发出栈时读到已经被别人取走的槽位也不会访问非法内存，CAS会因为tag变化而失败。
+ * 块的指针放在两级表中（pages_ -> 每页kChunksPerPage个块），页按需分配、发布后不再移动，
+ * index可以用满32位，实际上只有内存耗尽时create才会抛bad_alloc。
+ * 只有空闲链表为空、需要新分一块时才加锁，稳定运行后create/destroy都不再分配内存。
+ * 每个槽位带一个代数，destroy时加一，(指针, 代数)可以作为不会被复用混淆的句柄。
+ */
+template <typename T>
+class ObjectPool : noncopyable
+{
+public:
+    static const uint32_t kChunkSize = 256;
+    static const uint32_t kChunksPerPage = 4096;
+    static const uint32_t kMaxPages = 4096;
+    // index + 1要放进32位：最多 2^32 - kChunkSize 个对象
+    static const uint32_t kMaxChunks = kMaxPages * kChunksPerPage - 1;
+
+    ObjectPool() : freeHead_(0), numChunks_(0)
+    {
+        for (uint32_t i = 0; i < kMaxPages; ++i)
+            pages_[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    // 析构前调用者必须已经destroy所有对象
+    ~ObjectPool()
+    {
+        for (uint32_t i = 0; i < numChunks_.load(std::memory_order_relaxed); ++i)
+            delete[] chunkAt(i);
+        for (uint32_t i = 0; i < kMaxPages; ++i)
+            delete[] pages_[i].load(std::memory_order_relaxed);
+    }
+
+    template <typename... Args>
+    T *create(Args &&...args)
+    {
+        Slot *slot = pop();
+        if (slot == nullptr)
+            slot = grow();
+        return ::new (static_cast<void *>(slot->storage)) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T *obj)
+    {
+        obj->~T();
+        Slot *slot = reinterpret_cast<Slot *>(obj);
+        slot->generation.fetch_add(1, std::memory_order_relaxed); // 由push的release发布给下一个create的线程
+        push(slot);
+    }
+
+    // obj所在槽位的代数：create之后、destroy之前不变。槽位内存在池析构之前不会释放，
+    // 所以对象已经destroy之后也可以调用，用来判断旧句柄是否还指向当初create出来的对象
+    uint32_t generation(const T *obj) const
+    {
+        return reinterpret_cast<const Slot *>(obj)->generation.load(std::memory_order_relaxed);
+    }
+
+    // 已经分配的槽位总数
+    size_t capacity() const { return static_cast<size_t>(numChunks_.load(std::memory_order_acquire)) * kChunkSize; }
+
+private:
+    struct Slot
+    {
+        alignas(T) unsigned char storage[sizeof(T)]; // 必须在开头，destroy时由T*直接转换回Slot*
+        uint32_t index;
+        std::atomic<uint32_t> next; // 空闲链表中下一个槽位的 index + 1，0表示没有
+        std::atomic<uint32_t> generation;
+    };
+
+    using Page = std::atomic<Slot *>[kChunksPerPage];
+
+    Slot *chunkAt(uint32_t chunk) const
+    {
+        const std::atomic<Slot *> *page = pages_[chunk / kChunksPerPage].load(std::memory_order_acquire);
+        return page[chunk % kChunksPerPage].load(std::memory_order_acquire);
+    }
+
+    Slot *slotAt(uint32_t index) const { return &chunkAt(index / kChunkSize)[index % kChunkSize]; }
+
+    Slot *pop()
+    {
+        uint64_t head = freeHead_.load(std::memory_order_acquire);
+        for (;;)
+        {
+            uint32_t top = static_cast<uint32_t>(head);
+            if (top == 0)
+                return nullptr;
+            Slot *slot = slotAt(top - 1);
+            uint64_t next = ((head >> 32) + 1) << 32 | slot->next.load(std::memory_order_relaxed);
+            if (freeHead_.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire))
+                return slot;
+        }
+    }
+
+    void push(Slot *slot)
+    {
+        uint64_t head = freeHead_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            slot->next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            uint64_t next = ((head >> 32) + 1) << 32 | (slot->index + 1);
+            if (freeHead_.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed))
+                return;
+        }
+    }
+
+    // 分配一块新的槽位，返回其中一个，其余放进空闲链表
+    Slot *grow()
+    {
+        std::lock_guard<std::mutex> lock(growMutex_);
+        // 等锁期间别的线程可能已经扩容
+        if (Slot *slot = pop())
+            return slot;
+        uint32_t n = numChunks_.load(std::memory_order_relaxed);
+        if (n == kMaxChunks)
+            throw std::bad_alloc();
+        std::atomic<Slot *> *page = pages_[n / kChunksPerPage].load(std::memory_order_relaxed);
+        if (page == nullptr)
+        {
+            page = new Page;
+            for (uint32_t i = 0; i < kChunksPerPage; ++i)
+                page[i].store(nullptr, std::memory_order_relaxed);
+            pages_[n / kChunksPerPage].store(page, std::memory_order_release);
+        }
+        Slot *chunk = new Slot[kChunkSize];
+        for (uint32_t i = 0; i < kChunkSize; ++i)
+        {
+            chunk[i].index = n * kChunkSize + i;
+            chunk[i].generation.store(0, std::memory_order_relaxed);
+        }
+        page[n % kChunksPerPage].store(chunk, std::memory_order_release);
+        numChunks_.store(n + 1, std::memory_order_release);
+        for (uint32_t i = 1; i < kChunkSize; ++i)
+            push(&chunk[i]);
+        return &chunk[0];
+    }
+
+    alignas(64) std::atomic<uint64_t> freeHead_;
+    std::atomic<uint32_t> numChunks_;
+    std::mutex growMutex_;
+    std::atomic<std::atomic<Slot *> *> pages_[kMaxPages];
+};
@@ -1,9 +1,9 @@
 #include "Timer.h"
 
-void Timer::restart(Timestamp now)
+void Timer::restart(MonoTimestamp now)
 {
     if(repeat_)
         expiration_ = addTime(now, interval_);
     else
-        expiration_ = Timestamp::invalid();
+        expiration_ = MonoTimestamp::invalid();
 }
\ No newline at end of file
@@ -1,21 +1,31 @@
 #pragma once
 
-#include "Timestamp.h"
+#include "InlineFunction.h"
+#include "MonoTimestamp.h"
 #include "noncopyable.h"
 
-#include <functional>
-#include <memory>
+#include <stdint.h>
 
+/**
+ * 定时器，从所属TimerQueue的对象池中分配，由TimerQueue负责回收
+ * 回调放在内部存储中（捕获不超过64字节时不分配堆内存），
+ * 容器需要的链表指针/下标也直接放在Timer里，加入和取出容器都不分配内存
+ */
 class Timer : noncopyable {
 public:
-    using TimerCallback = std::function<void()>;
+    using TimerCallback = InlineFunction<void()>;
 
-    Timer(const TimerCallback& cb, Timestamp when, double interval)
-        : callback_(cb),
+    Timer(TimerCallback cb, MonoTimestamp when, double interval)
+        : callback_(std::move(cb)),
           expiration_(when),
           interval_(interval),
           repeat_(interval > 0.0),
-          canceled_(false) {}
+          canceled_(false),
+          rescheduled_(false),
+          sequence_(0),
+          prev_(nullptr),
+          next_(nullptr),
+          index_(-1) {}
 
     void run() const {
         callback_();
@@ -24,28 +34,33 @@ public:
     void cancel() { canceled_ = true; }
 
     bool repeat() const { return repeat_&&!canceled_; }
-    Timestamp expiration() const { return expiration_; }
+    bool canceled() const { return canceled_; }
+    MonoTimestamp expiration() const { return expiration_; }
     double interval() const { return interval_; }
 
-    void restart(Timestamp now);
+    void restart(MonoTimestamp now);
+    // 只能在定时器不在TimerQueue的容器中时调用（容器按到期时间索引）
+    void setExpiration(MonoTimestamp when) { expiration_ = when; }
 
-    struct Hash {
-        size_t operator()(const std::shared_ptr<Timer>& timer) const {
-            return reinterpret_cast<size_t>(timer.get());
-        }
-    };
-
-    struct Equal {
-        bool operator()(const std::shared_ptr<Timer>& a,
-                        const std::shared_ptr<Timer>& b) const {
-            return a.get() == b.get();
-        }
-    };
+    // 不在容器中时（回调执行期间）被延期过，回调结束后按新的到期时间重新加入，而不是按间隔重复或者回收
+    bool rescheduled() const { return rescheduled_; }
+    void setRescheduled(bool on) { rescheduled_ = on; }
 
 private:
+    friend class TimerHeap;
+    friend class TimerSet;
+    friend class TimerWheel;
+
     TimerCallback callback_;
-    Timestamp expiration_;
+    MonoTimestamp expiration_;
     double interval_;
     bool repeat_;
     bool canceled_;
-};
\ No newline at end of file
+    bool rescheduled_;
+
+    // 以下由所在的TimerContainer使用，index_为-1表示不在容器中
+    uint64_t sequence_; // TimerHeap/TimerSet：到期时间相同的按加入顺序触发
+    Timer* prev_;       // TimerWheel：槽位链表
+    Timer* next_;
+    int index_;         // TimerHeap中的下标 / TimerWheel中的槽位 / TimerSet中为0
+};
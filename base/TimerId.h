@@ -1,20 +1,24 @@
 #pragma once
 
 #include "Timer.h"
-#include <memory>
+#include <stdint.h>
 
+// 定时器的句柄：(Timer地址, 所在对象池槽位的代数)
+// 槽位被回收复用时代数会变化，旧句柄不会误取消/延期新的定时器；取消/延期时直接定位，不需要在容器里查找
 class TimerId
 {
   public:
-    TimerId() = default;
-    explicit TimerId(std::shared_ptr<Timer> timer) : timer_(timer) {}
+    TimerId() : timer_(nullptr), generation_(0) {}
+    TimerId(Timer* timer, uint32_t generation) : timer_(timer), generation_(generation) {}
 
-    std::shared_ptr<Timer> timer() const { return timer_.lock(); }
+    Timer* timer() const { return timer_; }
+    uint32_t generation() const { return generation_; }
 
     static TimerId invalid() {
         return TimerId();
     }
 
   private:
-    std::weak_ptr<Timer> timer_;
-};
\ No newline at end of file
+    Timer* timer_;
+    uint32_t generation_;
+};
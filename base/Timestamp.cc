@@ -1,15 +1,16 @@
 #include <Timestamp.h>
 
+#include <time.h>
+
 // 获取当前时间戳
 Timestamp Timestamp::now()
 {
-    struct timeval tv;
-    // 获取微妙和秒
-    // 在x86-64平台gettimeofday()已不是系统调用,不会陷入内核, 多次调用不会有性能损失.
-    gettimeofday(&tv, NULL);
-    int64_t seconds = tv.tv_sec;
+    struct timespec ts;
+    // 在x86-64平台clock_gettime()通过vDSO完成,不会陷入内核, 多次调用不会有性能损失.
+    clock_gettime(CLOCK_REALTIME, &ts);
+    int64_t seconds = ts.tv_sec;
     // 转换为微妙
-    return Timestamp(seconds * kMicroSecondsPerSecond + tv.tv_usec);
+    return Timestamp(seconds * kMicroSecondsPerSecond + ts.tv_nsec / 1000);
 }
 std::string Timestamp::toString()const
 {
@@ -3,10 +3,13 @@
 
 #include "EventLoop.h"
 #include "InetAddress.h"
+#include "IoUringPoller.h"
+#include "LogLimiter.h"
 #include "Logger.h"
 
 
 #include <errno.h>
+#include <string.h>
 
 static int createNonblocking()
 {
@@ -19,7 +22,8 @@ static int createNonblocking()
 }
 
 Acceptor::Acceptor(EventLoop *loop, const InetAddress &listenAddr)
-    : loop_(loop), acceptSocket_(createNonblocking()), acceptChannel_(loop, acceptSocket_.fd()), listenning_(false)
+    : loop_(loop), acceptSocket_(createNonblocking()), acceptChannel_(loop, acceptSocket_.fd()), listenning_(false),
+      ioUringRequested_(false), ioUring_(nullptr), ioUringToken_(0), retryPending_(false)
 {
     acceptSocket_.setReuseAddr(true);
     acceptSocket_.setReusePort(true);
@@ -32,7 +36,17 @@ Acceptor::Acceptor(EventLoop *loop, const InetAddress &listenAddr)
 
 Acceptor::~Acceptor()
 {
-
+    if (retryPending_)
+        loop_->cancel(retryTimer_);
+    if (ioUring_ != nullptr)
+    {
+        ioUring_->removeCompletionHandler(ioUringToken_);
+        struct io_uring_sqe *sqe = ioUring_->getSqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = IoUringPoller::completionUserData(ioUringToken_, kAcceptOp);
+        sqe->user_data = IoUringPoller::completionUserData(ioUringToken_, kCancelOp);
+    }
 }
 
 void Acceptor::listen()
@@ -40,7 +54,80 @@ void Acceptor::listen()
     loop_->assertInLoopThread();
     listenning_ = true;
     acceptSocket_.listen();
-    acceptChannel_.enableReading();
+    if (ioUringRequested_ && loop_->ioUringPoller() != nullptr)
+    {
+        ioUring_ = loop_->ioUringPoller();
+        ioUringToken_ = ioUring_->addCompletionHandler(
+            [this](const struct io_uring_cqe &cqe, Timestamp) { this->handleAcceptCompletion(cqe); });
+        armAccept();
+    }
+    else
+    {
+        acceptChannel_.enableReading();
+    }
+}
+
+// 一次提交持续产生新连接，只有出错结束时才需要重新提交
+void Acceptor::armAccept()
+{
+    struct io_uring_sqe *sqe = ioUring_->getSqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = acceptSocket_.fd();
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = IoUringPoller::completionUserData(ioUringToken_, kAcceptOp);
+}
+
+void Acceptor::handleAcceptCompletion(const struct io_uring_cqe &cqe)
+{
+    loop_->assertInLoopThread();
+    if (cqe.res >= 0)
+    {
+        int connfd = cqe.res;
+        // multishot accept不回填对端地址，单独取一次
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        ::memset(&addr, 0, sizeof(addr));
+        ::getpeername(connfd, (struct sockaddr *)&addr, &len);
+        InetAddress peerAddr(addr);
+        if (newConnectionCallback_)
+            newConnectionCallback_(connfd, peerAddr);
+        else
+            ::close(connfd);
+    }
+    else
+    {
+        // 文件描述符耗尽时每个就绪事件都会失败，限流避免刷屏
+        LOG_ERROR_RATELIMIT(10) << "accept Err errno=" << -cqe.res;
+        if (cqe.res == -EMFILE)
+        {
+            LOG_ERROR_RATELIMIT(10) << "sockfd reached limit";
+        }
+    }
+    if (cqe.flags & IORING_CQE_F_MORE)
+        return;
+    // multishot accept结束了，需要重新提交
+    if (cqe.res == -EINVAL)
+    {
+        // 内核不支持multishot accept（5.19之前），重新提交也会立即失败，退回就绪事件+accept
+        LOG_WARN << "Acceptor: multishot accept unsupported, fall back to readiness accept";
+        ioUring_->removeCompletionHandler(ioUringToken_);
+        ioUring_ = nullptr;
+        acceptChannel_.enableReading();
+    }
+    else if (cqe.res == -EMFILE || cqe.res == -ENFILE)
+    {
+        // fd耗尽时立即重新提交只会马上再失败，等一会儿（期间可能有连接关闭）再试
+        retryPending_ = true;
+        retryTimer_ = loop_->runAfter(kAcceptRetryDelay, [this]() {
+            retryPending_ = false;
+            armAccept();
+        });
+    }
+    else
+    {
+        armAccept();
+    }
 }
 //没有考虑文件描述符耗尽
 void Acceptor::handleRead()
@@ -57,10 +144,12 @@ void Acceptor::handleRead()
     }
     else
     {
-        LOG_ERROR<<"accept Err";
-        if (errno == EMFILE)
+        int savedErrno = errno;
+        // 文件描述符耗尽时每个就绪事件都会失败，限流避免刷屏
+        LOG_ERROR_RATELIMIT(10) << "accept Err errno=" << savedErrno;
+        if (savedErrno == EMFILE)
         {
-            LOG_ERROR<<"sockfd reached limit";
+            LOG_ERROR_RATELIMIT(10) << "sockfd reached limit";
         }
     }
 }
@@ -2,11 +2,15 @@
 
 #include "noncopyable.h"
 #include <functional>
+#include <stdint.h>
 #include "Socket.h"
 #include "Channel.h"
+#include "TimerId.h"
 
 class EventLoop;
 class InetAddress;
+class IoUringPoller;
+struct io_uring_cqe;
 
 class Acceptor : noncopyable
 {
@@ -21,15 +25,34 @@ class Acceptor : noncopyable
             newConnectionCallback_ = cb;
         }
 
+        // loop使用io_uring Poller时改用multishot accept，必须在listen之前设置
+        void setIoUringMode(bool on) {ioUringRequested_ = on;}
+
         bool listenning() const {return listenning_;}
         void listen();
 
     private:
+        enum IoUringOp : uint8_t
+        {
+            kAcceptOp,
+            kCancelOp,
+        };
+
+        // multishot accept因为fd耗尽而结束时，隔一段时间再重新提交，避免提交-失败的死循环
+        static constexpr double kAcceptRetryDelay = 0.1;
+
         void handleRead();
+        void armAccept();
+        void handleAcceptCompletion(const struct io_uring_cqe& cqe);
 
         EventLoop* loop_;
         Socket acceptSocket_;
         Channel acceptChannel_;
         NewConnectionCallback newConnectionCallback_;
         bool listenning_;
+        bool ioUringRequested_;
+        IoUringPoller* ioUring_;
+        uint64_t ioUringToken_;
+        bool retryPending_;   // 已经用定时器安排了重新提交accept
+        TimerId retryTimer_;
 };
\ No newline at end of file
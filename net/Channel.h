@@ -30,10 +30,12 @@ class Channel : noncopyable
         bool isNoneEvent() const {return events_ == KNoneEvent;}
 
         void enableReading() {events_ |= KReadEvent; update();}
+        void disableReading() {events_ &= ~KReadEvent; update();}
         void enableWriting() {events_ |= KWriteEvent; update();}
         void disableWriting() {events_ &= ~KWriteEvent; update();}
         void disableAll() {events_ = KNoneEvent; update();}
         bool isWriting() const {return events_ & KWriteEvent;}
+        bool isReading() const {return events_ & KReadEvent;}
 
         //for Poller
         int index() { return index_; }
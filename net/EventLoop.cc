@@ -1,10 +1,12 @@
 #include "EventLoop.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <sys/eventfd.h>
 #include <functional>
 #include <signal.h>
 
+#include "IoUringPoller.h"
 #include "Logger.h"
 #include "Poller.h"
 #include "TimerQueue.h"
@@ -13,6 +15,7 @@
 thread_local EventLoop *t_loopInThisThread = nullptr;
 
 const int kPollTimeMs = 5000;
+const int64_t kMinSpinBudgetUs = 10;
 
 static int createEventfd()
 {
@@ -38,8 +41,10 @@ IgnoreSigPipe initobj;
 
 // 每个线程至多一个EventLoop
 EventLoop::EventLoop()
-    : looping_(false), threadId_(CurrentThread::tid()), poller_(Poller::newDefaultPoller(this)), timerQueue_(new TimerQueue(this)),
-      wakeupFd_(createEventfd()), wakeupChannel_(new Channel(this, wakeupFd_))
+    : looping_(false), callingPendingFunctors_(false), threadId_(CurrentThread::tid()), poller_(Poller::newDefaultPoller(this)),
+      ioUringPoller_(dynamic_cast<IoUringPoller *>(poller_.get())), now_(MonoTimestamp::now()), timerQueue_(new TimerQueue(this)),
+      wakeupFd_(createEventfd()), wakeupChannel_(new Channel(this, wakeupFd_)), wakeupPending_(false), wakeupWrites_(0), wakeupsSaved_(0), busyPollUs_(0), spinBudgetUs_(0),
+      busyPollHits_(0), busyPollMisses_(0)
 {
     LOG_TRACE << "EventLoop created " << this << " in thread " << threadId_;
     if (t_loopInThisThread)
@@ -79,11 +84,17 @@ void EventLoop::loop()
     while (!quit_)
     {
         activeChannels_.clear();
-        pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+        if (busyPollUs_ > 0)
+            pollReturnTime_ = busyPoll();
+        else
+            pollReturnTime_ = poller_->poll(timerQueue_->pollTimeoutMs(kPollTimeMs), &activeChannels_);
+        now_ = MonoTimestamp::now();
         for (ChannelList::iterator it = activeChannels_.begin(); it != activeChannels_.end(); ++it)
         {
             (*it)->handleEvent(pollReturnTime_);
         }
+        // poll超时模式：poll的超时由最早的定时器决定，返回后在这里执行到期的定时器
+        timerQueue_->processExpired();
         doPendingFunctors();
     }
     LOG_TRACE << "EventLoop " << this << " stop looping";
@@ -98,21 +109,25 @@ void EventLoop::quit()
         wakeup();
 }
 
-TimerId EventLoop::runAt(const Timestamp &time, const Timer::TimerCallback &cb)
+MonoTimestamp EventLoop::timerBase() const
 {
-    return timerQueue_->addTimer(cb, time, 0.0);
+    // loop()开始之前now_还是构造时的值，不能用
+    return isInLoopThread() && looping_ ? now_ : MonoTimestamp::now();
 }
 
-TimerId EventLoop::runAfter(double delay, const Timer::TimerCallback &cb)
+TimerId EventLoop::runAt(const Timestamp &time, Timer::TimerCallback cb)
 {
-    Timestamp time(addTime(Timestamp::now(), delay));
-    return runAt(time, cb);
+    return timerQueue_->addTimer(std::move(cb), MonoTimestamp::fromTimestamp(time), 0.0);
 }
 
-TimerId EventLoop::runEvery(double interval, const Timer::TimerCallback &cb)
+TimerId EventLoop::runAfter(double delay, Timer::TimerCallback cb)
 {
-    Timestamp time(addTime(Timestamp::now(), interval));
-    return timerQueue_->addTimer(cb, time, interval);
+    return timerQueue_->addTimer(std::move(cb), addTime(timerBase(), delay), 0.0);
+}
+
+TimerId EventLoop::runEvery(double interval, Timer::TimerCallback cb)
+{
+    return timerQueue_->addTimer(std::move(cb), addTime(timerBase(), interval), interval);
 }
 
 void EventLoop::updateChannel(Channel *channel)
@@ -122,40 +137,41 @@ void EventLoop::updateChannel(Channel *channel)
     poller_->updateChannel(channel);
 }
 
-void EventLoop::runInLoop(const Functor &cb)
+void EventLoop::runInLoop(Functor cb)
 {
     if (isInLoopThread())
         cb();
     else
-        queueInLoop(cb);
+        queueInLoop(std::move(cb));
 }
 
-void EventLoop::queueInLoop(const Functor &cb)
+void EventLoop::queueInLoop(Functor cb)
 {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        pendingFunctors_.push_back(cb);
-    }
+    pendingFunctors_.push(std::move(cb));
     // 如果doPendingFunctors正在被调用，他调用的Functor可能又调用了queueInLoop，必需wakeup，否则新的cb不能被即时调用
     if (!isInLoopThread() || callingPendingFunctors_)
-        wakeup();
+    {
+        // 入队在前、置位在后：看到wakeupPending_已经为true时，loop清除标志之后的drain一定能取到这个Functor
+        if (!wakeupPending_.exchange(true, std::memory_order_acq_rel))
+            wakeup();
+        else
+            wakeupsSaved_.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
 void EventLoop::doPendingFunctors()
 {
-    std::vector<Functor> functors;
     callingPendingFunctors_ = true;
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        functors.swap(pendingFunctors_);
-    }
-    for (const auto &func : functors)
-        func();
+    // 先清除标志再取队列，之后入队的Functor会重新唤醒
+    wakeupPending_.exchange(false, std::memory_order_acq_rel);
+    // 只执行进入时已经入队的Functor，执行过程中新加入的留到下一轮（queueInLoop会wakeup）
+    pendingFunctors_.drain([](Functor &func) { func(); });
     callingPendingFunctors_ = false;
 }
 
 void EventLoop::wakeup()
 {
+    wakeupWrites_.fetch_add(1, std::memory_order_relaxed);
     uint64_t one = 1;
     ssize_t n = ::write(wakeupFd_, &one, sizeof one);
     if (n != sizeof one)
@@ -184,4 +200,76 @@ void EventLoop::removeChannel(Channel* channel)
 void EventLoop::cancel(TimerId timerId)
 {
     return timerQueue_->cancel(timerId);
-}
\ No newline at end of file
+}
+
+void EventLoop::extend(TimerId timerId, const Timestamp &when)
+{
+    timerQueue_->extend(timerId, MonoTimestamp::fromTimestamp(when));
+}
+
+void EventLoop::extendAfter(TimerId timerId, double delay)
+{
+    timerQueue_->extend(timerId, addTime(timerBase(), delay));
+}
+
+EventLoop::Stats EventLoop::stats() const
+{
+    Stats s;
+    s.wakeupWrites = wakeupWrites_.load(std::memory_order_relaxed);
+    s.wakeupsSaved = wakeupsSaved_.load(std::memory_order_relaxed);
+    s.busyPollHits = busyPollHits_.load(std::memory_order_relaxed);
+    s.busyPollMisses = busyPollMisses_.load(std::memory_order_relaxed);
+    s.spinBudgetUs = spinBudgetUs_.load(std::memory_order_relaxed);
+    s.timerfdUpdates = timerQueue_->timerfdUpdates();
+    s.timerfdUpdatesSaved = timerQueue_->timerfdUpdatesSaved();
+    s.timerWakeups = timerQueue_->wakeups();
+    s.timersFired = timerQueue_->timersFired();
+    return s;
+}
+
+void EventLoop::setBusyPoll(int64_t maxSpinUs)
+{
+    runInLoop([this, maxSpinUs]() {
+        busyPollUs_ = std::max<int64_t>(maxSpinUs, 0);
+        spinBudgetUs_.store(busyPollUs_, std::memory_order_relaxed);
+    });
+}
+
+void EventLoop::setTimerSlack(int64_t slackUs)
+{
+    runInLoop([this, slackUs]() { timerQueue_->setSlack(slackUs); });
+}
+
+// 先自旋spinBudgetUs_微秒，没有事件再阻塞等待；根据结果调整下一轮的自旋预算
+Timestamp EventLoop::busyPoll()
+{
+    int64_t budget = spinBudgetUs_.load(std::memory_order_relaxed);
+    // 自旋时间用单调时钟计算，不受系统时间调整影响；返回值仍是poll返回时的系统时间
+    int64_t start = MonoTimestamp::now().microSeconds();
+    Timestamp now;
+    for (;;)
+    {
+        now = poller_->poll(0, &activeChannels_);
+        if (!activeChannels_.empty())
+        {
+            busyPollHits_.fetch_add(1, std::memory_order_relaxed);
+            spinBudgetUs_.store(std::min(busyPollUs_, std::max(budget * 2, kMinSpinBudgetUs)),
+                                std::memory_order_relaxed);
+            return now;
+        }
+        if (MonoTimestamp::now().microSeconds() - start >= budget || quit_)
+            break;
+    }
+
+    busyPollMisses_.fetch_add(1, std::memory_order_relaxed);
+    // 自旋期间定时器可能已经到期，超时在自旋之后计算
+    now = poller_->poll(timerQueue_->pollTimeoutMs(kPollTimeMs), &activeChannels_);
+    int64_t waited = MonoTimestamp::now().microSeconds() - start;
+    // 事件在最大预算之内就到了，多自旋一会儿就能省掉这次睡眠和唤醒；否则说明正在空闲，减少自旋
+    if (!activeChannels_.empty() && waited <= busyPollUs_)
+        budget = std::min(busyPollUs_, std::max(budget * 2, kMinSpinBudgetUs));
+    else
+        budget /= 2;
+    spinBudgetUs_.store(budget, std::memory_order_relaxed);
+    return now;
+}
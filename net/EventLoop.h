@@ -8,11 +8,14 @@
 #include <sys/syscall.h>
 #include <vector>
 #include <Channel.h>
+#include <atomic>
 #include <memory>
-#include <mutex>
 
+#include "InlineFunction.h"
+#include "MpscQueue.h"
 #include "TimerId.h"
 
+class IoUringPoller;
 class Poller;
 class Timestamp;
 class TimerQueue;
@@ -20,7 +23,22 @@ class TimerQueue;
 class EventLoop : noncopyable
 {
     public:
-        using Functor = std::function<void()>;
+        // 跨线程投递的任务：捕获不超过64字节（例如this加一个std::string）时不分配堆内存
+        using Functor = InlineFunction<void(), 64>;
+
+        // 运行统计，任意线程可读，数值只是近似的瞬时值
+        struct Stats
+        {
+            uint64_t wakeupWrites;  // 实际写eventfd的次数
+            uint64_t wakeupsSaved;  // 因为已有未处理的唤醒而省掉的写
+            uint64_t busyPollHits;  // 自旋期间等到事件的次数
+            uint64_t busyPollMisses;// 自旋预算用完、转入阻塞等待的次数
+            int64_t spinBudgetUs;   // 当前的自旋预算
+            uint64_t timerfdUpdates;      // timerfd_settime的调用次数，poll模式（TIMER_SOURCE，见TimerQueue）下为0
+            uint64_t timerfdUpdatesSaved; // 已设置的唤醒时间落在新定时器的容差范围内而省掉的调用
+            uint64_t timerWakeups;        // 处理到期定时器的次数（timerfd触发，或者poll模式下poll返回后有定时器到期）
+            uint64_t timersFired;         // 到期执行的定时器个数，和timerWakeups之比就是每次唤醒合并的定时器数
+        };
 
         EventLoop();
         ~EventLoop();
@@ -44,18 +62,42 @@ class EventLoop : noncopyable
 
         void quit();
 
-        TimerId runAt(const Timestamp& time, const Timer::TimerCallback& cb);
-        TimerId runAfter(double delay, const Timer::TimerCallback& cb);
-        TimerId runEvery(double interval, const Timer::TimerCallback& cb);
+        // 定时器使用单调时钟，修改系统时间不影响已经加入的定时器；
+        // runAt按调用时刻两个时钟的差值把time换算到单调时钟上
+        TimerId runAt(const Timestamp& time, Timer::TimerCallback cb);
+        // 在loop线程中调用时，延迟从now()（本轮poll返回的时刻）算起
+        TimerId runAfter(double delay, Timer::TimerCallback cb);
+        TimerId runEvery(double interval, Timer::TimerCallback cb);
 
         void removeChannel(Channel* channel);
 
-        void runInLoop(const Functor& cb);
-        void queueInLoop(const Functor& cb);
+        void runInLoop(Functor cb);
+        void queueInLoop(Functor cb);
 
         Timestamp pollReturnTime() const {return pollReturnTime_;}
+        // 本轮poll返回时读取的单调时钟，同一轮事件处理中重复使用，不必每次都读时钟。只能在loop线程调用
+        MonoTimestamp now() const {return now_;}
 
         void cancel(TimerId timerId);
+        // 推迟（或提前）一个还没有触发的定时器，原地重新排队，用于刷新空闲超时这类场景，比cancel后重新runAfter少一次分配
+        // 重复定时器之后仍然按原来的间隔重复；在定时器自己的回调里调用时会让它在when再触发一次
+        void extend(TimerId timerId, const Timestamp& when);
+        void extendAfter(TimerId timerId, double delay);
+
+        // 使用io_uring Poller时返回它，供完成式I/O提交请求；其它实现返回nullptr
+        IoUringPoller* ioUringPoller() const {return ioUringPoller_;}
+
+        Stats stats() const;
+
+        // 忙轮询模式：阻塞在poll之前先用0超时的poll自旋，最多maxSpinUs微秒，0表示关闭（默认）
+        // 实际自旋预算在(0, maxSpinUs]之间自适应：自旋或者很快就等到事件时翻倍，空闲时减半，
+        // 流量停止后很快退化为普通的阻塞等待，不会一直占满一个核。Thread safe
+        void setBusyPoll(int64_t maxSpinUs);
+
+        // 定时器容差：定时器最多推迟slackUs微秒触发，唤醒时间按slackUs对齐，
+        // 容差范围内到期的定时器在同一次唤醒中批量处理，也不必每加入一个更早的定时器就重设timerfd。
+        // 0表示按到期时间精确唤醒（默认）。Thread safe
+        void setTimerSlack(int64_t slackUs);
     
     private:
         using ChannelList = std::vector<Channel*>;
@@ -64,6 +106,9 @@ class EventLoop : noncopyable
         void wakeup();
         void handleRead();//wake up
         void doPendingFunctors();
+        Timestamp busyPoll();
+        // 计算定时器到期时间的基准：loop()中的loop线程用缓存的now_，其它情况读当前时钟
+        MonoTimestamp timerBase() const;
 
 
 
@@ -75,11 +120,21 @@ class EventLoop : noncopyable
         bool callingPendingFunctors_;//atomic
         const pid_t threadId_;
         std::unique_ptr<Poller> poller_;
+        IoUringPoller* ioUringPoller_;
         Timestamp pollReturnTime_;
+        MonoTimestamp now_;
         ChannelList activeChannels_;
         std::unique_ptr<TimerQueue> timerQueue_;
         int wakeupFd_;
         std::unique_ptr<Channel> wakeupChannel_;
-        std::mutex mutex_;
-        std::vector<Functor> pendingFunctors_; //暴露给线程，需要mutex保护
+        MpscQueue<Functor> pendingFunctors_; //暴露给其他线程，无锁多生产者单消费者队列
+        // 已经写过eventfd、loop还没开始处理pendingFunctors_，期间入队的Functor不必再唤醒
+        std::atomic<bool> wakeupPending_;
+        std::atomic<uint64_t> wakeupWrites_;
+        std::atomic<uint64_t> wakeupsSaved_;
+        // 忙轮询，只在loop线程中修改
+        int64_t busyPollUs_;
+        std::atomic<int64_t> spinBudgetUs_;
+        std::atomic<uint64_t> busyPollHits_;
+        std::atomic<uint64_t> busyPollMisses_;
 };
\ No newline at end of file
@@ -38,4 +38,12 @@ EventLoop* EventLoopThreadPool::getNextLoop()
             next_= 0;
     }
     return loop;
-}
\ No newline at end of file
+}
+std::vector<EventLoop*> EventLoopThreadPool::getAllLoops()
+{
+    baseloop_->assertInLoopThread();
+    assert(started_);
+    if(loops_.empty())
+        return std::vector<EventLoop*>(1, baseloop_);
+    return loops_;
+}
@@ -17,6 +17,8 @@ class EventLoopThreadPool : noncopyable
         void setThreadNum(int numThreads) { numThreads_ = numThreads;}
         void start();
         EventLoop* getNextLoop();
+        // 所有IO loop，没有子线程时只有baseLoop
+        std::vector<EventLoop*> getAllLoops();
 
     private:
         EventLoop* baseloop_;
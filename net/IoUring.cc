@@ -0,0 +1,237 @@
+#include "IoUring.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+IoUring::IoUring(unsigned entries)
+    : ringFd_(-1), features_(0), sqRing_(MAP_FAILED), sqRingSize_(0), sqes_(nullptr), sqesSize_(0), sqeTail_(0),
+      sqeSubmitted_(0), cqRing_(MAP_FAILED), cqRingSize_(0)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0)
+    {
+        LOG_WARN << "io_uring_setup failed errno=" << errno;
+        return;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap && cqRingSize_ > sqRingSize_)
+        sqRingSize_ = cqRingSize_;
+
+    sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED)
+    {
+        LOG_WARN << "io_uring mmap sq ring failed errno=" << errno;
+        ::close(fd);
+        return;
+    }
+    if (singleMmap)
+    {
+        cqRing_ = sqRing_;
+    }
+    else
+    {
+        cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED)
+        {
+            LOG_WARN << "io_uring mmap cq ring failed errno=" << errno;
+            ::munmap(sqRing_, sqRingSize_);
+            sqRing_ = MAP_FAILED;
+            ::close(fd);
+            return;
+        }
+    }
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        LOG_WARN << "io_uring mmap sqes failed errno=" << errno;
+        if (cqRing_ != sqRing_)
+            ::munmap(cqRing_, cqRingSize_);
+        ::munmap(sqRing_, sqRingSize_);
+        sqRing_ = cqRing_ = MAP_FAILED;
+        ::close(fd);
+        return;
+    }
+    sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+
+    char *sq = static_cast<char *>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sqEntries_ = params.sq_entries;
+
+    char *cq = static_cast<char *>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    sqeTail_ = sqeSubmitted_ = *sqTail_;
+    features_ = params.features;
+    ringFd_ = fd;
+}
+
+IoUring::~IoUring()
+{
+    if (ringFd_ < 0)
+        return;
+    ::munmap(sqes_, sqesSize_);
+    if (cqRing_ != sqRing_)
+        ::munmap(cqRing_, cqRingSize_);
+    ::munmap(sqRing_, sqRingSize_);
+    ::close(ringFd_);
+}
+
+struct io_uring_sqe *IoUring::getSqe()
+{
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    if (sqeTail_ - head >= sqEntries_)
+    {
+        submit();
+        head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        if (sqeTail_ - head >= sqEntries_)
+            return nullptr;
+    }
+    unsigned index = sqeTail_ & *sqMask_;
+    struct io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqArray_[index] = index;
+    ++sqeTail_;
+    return sqe;
+}
+
+// 把本地取出的SQE发布给内核，返回内核还没有取走的SQE个数
+unsigned IoUring::flushSq()
+{
+    if (sqeTail_ != sqeSubmitted_)
+    {
+        __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+        sqeSubmitted_ = sqeTail_;
+    }
+    // 上一次io_uring_enter失败时已发布的SQE可能还没被内核取走，一并重新提交
+    return sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+}
+
+int IoUring::submit()
+{
+    unsigned toSubmit = flushSq();
+    if (toSubmit == 0)
+        return 0;
+    return enter(toSubmit, 0, 0, nullptr, 0);
+}
+
+int IoUring::submitAndWait(int timeoutMs)
+{
+    unsigned toSubmit = flushSq();
+    if (hasCqe())
+    {
+        // 已经有完成事件，只提交不等待
+        return toSubmit > 0 ? enter(toSubmit, 0, 0, nullptr, 0) : 0;
+    }
+    if (timeoutMs < 0)
+    {
+        return enter(toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    }
+
+    struct __kernel_timespec ts;
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = (timeoutMs % 1000) * 1000000LL;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<__u64>(&ts);
+    int ret = enter(toSubmit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    if (ret < 0 && errno == ETIME)
+        return 0;
+    return ret;
+}
+
+bool IoUring::hasCqe() const
+{
+    return *cqHead_ != __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+}
+
+int IoUring::enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void *arg, size_t argSize)
+{
+    int ret;
+    do
+    {
+        ret = static_cast<int>(::syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete, flags, arg, argSize));
+    } while (ret < 0 && errno == EINTR && minComplete == 0);
+    return ret;
+}
+
+IoUringBufferRing::IoUringBufferRing(IoUring &ring, uint16_t groupId, unsigned count, unsigned size)
+    : ring_(ring), groupId_(groupId), count_(count), size_(size), bufRing_(nullptr), bufRingSize_(0), buffers_(nullptr)
+{
+    // count必须是2的幂，环本身要求按页对齐，直接用mmap分配
+    bufRingSize_ = count_ * sizeof(struct io_uring_buf);
+    void *mem = ::mmap(nullptr, bufRingSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+    {
+        LOG_WARN << "IoUringBufferRing mmap failed errno=" << errno;
+        return;
+    }
+    void *buffers = ::mmap(nullptr, static_cast<size_t>(count_) * size_, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffers == MAP_FAILED)
+    {
+        LOG_WARN << "IoUringBufferRing mmap buffers failed errno=" << errno;
+        ::munmap(mem, bufRingSize_);
+        return;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<__u64>(mem);
+    reg.ring_entries = count_;
+    reg.bgid = groupId_;
+    if (::syscall(__NR_io_uring_register, ring_.fd(), IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        LOG_WARN << "io_uring_register PBUF_RING failed errno=" << errno;
+        ::munmap(buffers, static_cast<size_t>(count_) * size_);
+        ::munmap(mem, bufRingSize_);
+        return;
+    }
+    bufRing_ = static_cast<struct io_uring_buf_ring *>(mem);
+    buffers_ = static_cast<char *>(buffers);
+    for (unsigned i = 0; i < count_; ++i)
+    {
+        recycle(static_cast<uint16_t>(i));
+    }
+}
+
+IoUringBufferRing::~IoUringBufferRing()
+{
+    if (bufRing_ == nullptr)
+        return;
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.bgid = groupId_;
+    ::syscall(__NR_io_uring_register, ring_.fd(), IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    ::munmap(buffers_, static_cast<size_t>(count_) * size_);
+    ::munmap(bufRing_, bufRingSize_);
+}
+
+void IoUringBufferRing::recycle(uint16_t bid)
+{
+    // tail和bufs[0]的保留字段共用同一块内存，先填好缓冲区描述再发布tail
+    // 不能用bufRing_->bufs：C++下__DECLARE_FLEX_ARRAY的空结构体占1字节，bufs会偏移8字节
+    unsigned short tail = bufRing_->tail;
+    struct io_uring_buf *buf = reinterpret_cast<struct io_uring_buf *>(bufRing_) + (tail & (count_ - 1));
+    buf->addr = reinterpret_cast<__u64>(buffer(bid));
+    buf->len = size_;
+    buf->bid = bid;
+    __atomic_store_n(&bufRing_->tail, static_cast<unsigned short>(tail + 1), __ATOMIC_RELEASE);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <linux/io_uring.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * io_uring 的最小封装（直接使用系统调用，不依赖 liburing）
+ * 只负责 SQ/CQ 环的映射、取SQE、提交和遍历CQE，具体操作由使用者填写SQE。
+ * 非线程安全，只能在所属EventLoop的线程中使用。
+ */
+class IoUring : noncopyable
+{
+public:
+    explicit IoUring(unsigned entries);
+    ~IoUring();
+
+    // io_uring_setup失败（内核不支持或被禁用）时返回false；
+    // submitAndWait的超时依赖IORING_ENTER_EXT_ARG（5.11+），不支持时同样视为不可用，由调用者退回epoll
+    bool valid() const { return ringFd_ >= 0 && (features_ & IORING_FEAT_EXT_ARG) != 0; }
+    unsigned features() const { return features_; }
+
+    // 取一个空闲的SQE并清零；SQ满时先提交一次，仍然没有空位返回nullptr
+    struct io_uring_sqe *getSqe();
+    // 提交所有已填写的SQE，不等待
+    int submit();
+    // 提交并等待至少一个CQE，timeoutMs < 0 表示一直等；超时返回0
+    int submitAndWait(int timeoutMs);
+
+    bool hasCqe() const;
+    int fd() const { return ringFd_; }
+    // 依次处理已完成的CQE，返回处理的个数
+    template <typename Func>
+    unsigned forEachCqe(Func &&func)
+    {
+        unsigned head = *cqHead_;
+        unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+        for (; head != tail; ++head, ++count)
+        {
+            func(cqes_[head & *cqMask_]);
+        }
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+private:
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void *arg, size_t argSize);
+    unsigned flushSq();
+
+    int ringFd_;
+    unsigned features_;
+
+    // SQ环
+    void *sqRing_;
+    size_t sqRingSize_;
+    unsigned *sqHead_;
+    unsigned *sqTail_;
+    unsigned *sqMask_;
+    unsigned *sqArray_;
+    unsigned sqEntries_;
+    struct io_uring_sqe *sqes_;
+    size_t sqesSize_;
+    unsigned sqeTail_;      // 本地已经取出的SQE位置，flushSq时发布给内核
+    unsigned sqeSubmitted_; // 已经发布给内核的位置
+
+    // CQ环（IORING_FEAT_SINGLE_MMAP时和SQ环共用一段映射）
+    void *cqRing_;
+    size_t cqRingSize_;
+    unsigned *cqHead_;
+    unsigned *cqTail_;
+    unsigned *cqMask_;
+    struct io_uring_cqe *cqes_;
+};
+
+/**
+ * 内核提供缓冲区环（IORING_REGISTER_PBUF_RING，5.19+）
+ * count个大小为size的缓冲区交给内核，recv时由内核挑选一个填数据，
+ * CQE中带回缓冲区编号bid，用户处理完后recycle归还。
+ */
+class IoUringBufferRing : noncopyable
+{
+public:
+    IoUringBufferRing(IoUring &ring, uint16_t groupId, unsigned count, unsigned size);
+    ~IoUringBufferRing();
+
+    bool valid() const { return bufRing_ != nullptr; }
+    uint16_t groupId() const { return groupId_; }
+    const char *buffer(uint16_t bid) const { return buffers_ + static_cast<size_t>(bid) * size_; }
+    // 把bid号缓冲区还给内核
+    void recycle(uint16_t bid);
+
+private:
+    IoUring &ring_;
+    uint16_t groupId_;
+    unsigned count_;
+    unsigned size_;
+    struct io_uring_buf_ring *bufRing_;
+    size_t bufRingSize_;
+    char *buffers_;
+};
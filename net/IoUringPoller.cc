@@ -0,0 +1,220 @@
+#include "IoUringPoller.h"
+#include "Channel.h"
+#include "Logger.h"
+
+#include <cassert>
+#include <cerrno>
+#include <poll.h>
+
+namespace
+{
+const int kNew = -1; //不在channel_内
+const int kAdded = 1;
+} // namespace
+
+IoUringPoller::IoUringPoller(EventLoop *loop)
+    : Poller(loop), ring_(kRingEntries), nextGeneration_(0), nextToken_(1), completionChannel_(loop, ring_.fd()),
+      bufferRingFailed_(false)
+{
+    completionChannel_.setReadCallback([this](Timestamp receiveTime) { this->handleCompletions(receiveTime); });
+}
+
+IoUringPoller::~IoUringPoller() = default;
+
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList *activeChannels)
+{
+    // 上一轮触发过的单次poll已经失效，关注的事件没有变化的在这里统一重新注册
+    for (int fd : fired_)
+    {
+        auto it = registrations_.find(fd);
+        if (it == registrations_.end() || it->second.armedEvents != 0)
+            continue;
+        Channel *channel = channels_[fd];
+        if (!channel->isNoneEvent())
+            arm(channel, it->second);
+    }
+    fired_.clear();
+
+    int ret = ring_.submitAndWait(timeoutMs);
+    Timestamp now(Timestamp::now());
+    int savedErrno = errno;
+    if (ret < 0 && savedErrno != EINTR)
+    {
+        errno = savedErrno;
+        LOG_ERROR << "IoUringPoller::poll() errno=" << savedErrno;
+    }
+    fillActiveChannels(activeChannels);
+    if (activeChannels->empty())
+    {
+        LOG_TRACE << "nothing happened";
+    }
+    else
+    {
+        LOG_TRACE << activeChannels->size() << " events happended";
+    }
+    return now;
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList *activeChannels)
+{
+    ring_.forEachCqe([this, activeChannels](const struct io_uring_cqe &cqe) {
+        Tag tag = static_cast<Tag>(cqe.user_data >> 56);
+        if (tag == kCompletionTag)
+        {
+            completions_.push_back(cqe);
+            return;
+        }
+        if (tag != kPollTag)
+            return; // POLL_REMOVE的结果不关心
+        int fd = static_cast<int>(static_cast<uint32_t>(cqe.user_data));
+        uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 32) & 0xffffff;
+        auto it = registrations_.find(fd);
+        if (it == registrations_.end() || (it->second.generation & 0xffffff) != generation)
+            return; // 已经取消或者重新注册过，丢弃过期事件
+        Registration &reg = it->second;
+        if (reg.armedEvents == 0)
+            return;
+        reg.armedEvents = 0;
+        fired_.push_back(fd);
+        if (cqe.res == -ECANCELED)
+            return;
+
+        Channel *channel = channels_[fd];
+        assert(channel != nullptr);
+        channel->set_revents_(cqe.res < 0 ? POLLERR : cqe.res);
+        activeChannels->push_back(channel);
+    });
+    if (!completions_.empty())
+    {
+        completionChannel_.set_revents_(POLLIN);
+        activeChannels->push_back(&completionChannel_);
+    }
+}
+
+void IoUringPoller::handleCompletions(Timestamp receiveTime)
+{
+    std::vector<struct io_uring_cqe> completions;
+    completions.swap(completions_);
+    for (const struct io_uring_cqe &cqe : completions)
+    {
+        uint64_t token = (cqe.user_data >> 8) & 0xffffffffffffULL;
+        auto it = completionHandlers_.find(token);
+        if (it == completionHandlers_.end())
+            continue;
+        // 回调里可能注销自己，先拷贝一份
+        CompletionCallback cb = it->second;
+        cb(cqe, receiveTime);
+    }
+}
+
+struct io_uring_sqe *IoUringPoller::getSqe()
+{
+    Poller::assertInLoopThread();
+    struct io_uring_sqe *sqe = ring_.getSqe();
+    if (sqe == nullptr)
+    {
+        LOG_FATAL << "IoUringPoller::getSqe submission queue full";
+    }
+    return sqe;
+}
+
+uint64_t IoUringPoller::addCompletionHandler(CompletionCallback cb)
+{
+    Poller::assertInLoopThread();
+    uint64_t token = nextToken_++;
+    completionHandlers_[token] = std::move(cb);
+    return token;
+}
+
+void IoUringPoller::removeCompletionHandler(uint64_t token)
+{
+    Poller::assertInLoopThread();
+    completionHandlers_.erase(token);
+}
+
+IoUringBufferRing *IoUringPoller::bufferRing()
+{
+    if (!bufferRing_ && !bufferRingFailed_)
+    {
+        bufferRing_.reset(new IoUringBufferRing(ring_, 0, kRecvBufferCount, kRecvBufferSize));
+        if (!bufferRing_->valid())
+        {
+            bufferRing_.reset();
+            bufferRingFailed_ = true;
+        }
+    }
+    return bufferRing_.get();
+}
+
+void IoUringPoller::updateChannel(Channel *channel)
+{
+    Poller::assertInLoopThread();
+    const int index = channel->index();
+    int fd = channel->fd();
+    LOG_TRACE << "fd = " << fd << " events = " << channel->events() << " index = " << index;
+    if (index == kNew)
+    {
+        assert(channels_.find(fd) == channels_.end());
+        channels_[fd] = channel;
+        channel->set_index(kAdded);
+        Registration &reg = registrations_[fd];
+        reg.generation = nextGeneration_++;
+        reg.armedEvents = 0;
+        if (!channel->isNoneEvent())
+            arm(channel, reg);
+    }
+    else
+    {
+        assert(channels_.find(fd) != channels_.end());
+        assert(channels_[fd] == channel);
+        assert(index == kAdded);
+        Registration &reg = registrations_[fd];
+        if (reg.armedEvents == static_cast<uint32_t>(channel->events()))
+            return;
+        if (reg.armedEvents != 0)
+            disarm(fd, reg);
+        if (!channel->isNoneEvent())
+            arm(channel, reg);
+    }
+}
+
+void IoUringPoller::removeChannel(Channel *channel)
+{
+    Poller::assertInLoopThread();
+    int fd = channel->fd();
+    LOG_TRACE << "fd = " << fd;
+    assert(channels_.find(fd) != channels_.end());
+    assert(channels_[fd] == channel);
+    assert(channel->isNoneEvent());
+    assert(channel->index() == kAdded);
+    size_t n = channels_.erase(fd);
+    assert(n == 1);
+
+    auto it = registrations_.find(fd);
+    if (it->second.armedEvents != 0)
+        disarm(fd, it->second);
+    registrations_.erase(it);
+    channel->set_index(kNew);
+}
+
+void IoUringPoller::arm(Channel *channel, Registration &reg)
+{
+    struct io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = channel->fd();
+    sqe->poll32_events = static_cast<uint32_t>(channel->events());
+    sqe->user_data = encode(kPollTag, reg.generation, channel->fd());
+    reg.armedEvents = static_cast<uint32_t>(channel->events());
+}
+
+void IoUringPoller::disarm(int fd, Registration &reg)
+{
+    struct io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = encode(kPollTag, reg.generation, fd);
+    sqe->user_data = encode(kRemoveTag, reg.generation, fd);
+    // 旧注册的完成事件（包括-ECANCELED）靠generation过滤掉
+    reg.generation = nextGeneration_++;
+    reg.armedEvents = 0;
+}
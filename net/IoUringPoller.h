@@ -0,0 +1,103 @@
+#pragma once
+#include "Channel.h"
+#include "IoUring.h"
+#include "Poller.h"
+
+#include <functional>
+#include <memory>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+class Channel;
+class EventLoop;
+
+/**
+ * 基于io_uring IORING_OP_POLL_ADD的Poller
+ * updateChannel不立即产生系统调用，只把POLL_ADD/POLL_REMOVE写进SQ，
+ * 下一次poll()时和等待事件合并成一次io_uring_enter提交。
+ *
+ * 没有使用multishot poll：multishot是边沿触发语义，而Channel按水平触发编写
+ * （handleRead一次不读完、handleWrite一次不写完都依赖下一轮继续通知）。
+ * 这里用单次POLL_ADD，事件返回后在下一次poll()提交时批量重新注册，
+ * POLL_ADD注册时会先检查一次就绪状态，所以语义和EPollPoller的LT一致。
+ *
+ * 另外提供完成式I/O的接口：使用者自己填写recv/send/accept等SQE，
+ * user_data用completionUserData(token, op)生成，完成事件按token分发给注册的回调。
+ * 完成事件由一个不注册到Poller的completionChannel_统一派发，和普通Channel在同一轮事件处理中执行。
+ */
+class IoUringPoller : public Poller
+{
+  public:
+    IoUringPoller(EventLoop *loop);
+    ~IoUringPoller() override;
+
+    using CompletionCallback = std::function<void(const struct io_uring_cqe &, Timestamp)>;
+
+    // io_uring不可用时返回false，由newDefaultPoller退回EPollPoller
+    bool valid() const { return ring_.valid(); }
+
+    // Polls the I/O events. Must be called in the loop thread
+    Timestamp poll(int timeoutMs, ChannelList *activeChannels) override;
+    /// Must be called in the loop thread.
+    void updateChannel(Channel *channel) override;
+    /// Must be called in the loop thread.
+    void removeChannel(Channel* channel) override;
+
+    // 以下接口用于完成式I/O，只能在loop线程调用
+    // 取一个SQE，随下一次poll()一起提交
+    struct io_uring_sqe *getSqe();
+    // 注册完成事件的回调，返回的token不会复用，注销之后迟到的完成事件直接丢弃
+    uint64_t addCompletionHandler(CompletionCallback cb);
+    void removeCompletionHandler(uint64_t token);
+    // 同一个token下用op区分不同的操作
+    static uint64_t completionUserData(uint64_t token, uint8_t op)
+    {
+        return (static_cast<uint64_t>(kCompletionTag) << 56) | ((token & 0xffffffffffffULL) << 8) | op;
+    }
+    static uint8_t completionOp(const struct io_uring_cqe &cqe) { return static_cast<uint8_t>(cqe.user_data); }
+    // 本loop所有连接共享的recv缓冲区环，第一次调用时创建，内核不支持时返回nullptr
+    IoUringBufferRing *bufferRing();
+
+  private:
+    // user_data = tag(8位) | generation(24位) | fd(32位)
+    enum Tag : uint64_t
+    {
+        kPollTag = 0,
+        kRemoveTag = 1,
+        kCompletionTag = 2,
+    };
+
+    struct Registration
+    {
+        uint32_t generation; // 每次取消注册后递增，用来丢弃过期的完成事件
+        uint32_t armedEvents; // 当前已提交的POLL_ADD关注的事件，0表示没有挂在ring上
+    };
+
+    static uint64_t encode(Tag tag, uint32_t generation, int fd)
+    {
+        return (static_cast<uint64_t>(tag) << 56) | (static_cast<uint64_t>(generation & 0xffffff) << 32) |
+               static_cast<uint32_t>(fd);
+    }
+
+    void arm(Channel *channel, Registration &reg);
+    void disarm(int fd, Registration &reg);
+    void fillActiveChannels(ChannelList *activeChannels);
+    void handleCompletions(Timestamp receiveTime);
+
+    static const unsigned kRingEntries = 1024;
+    static const unsigned kRecvBufferCount = 256; // 必须是2的幂
+    static const unsigned kRecvBufferSize = 8 * 1024;
+
+    IoUring ring_;
+    uint32_t nextGeneration_; // fd会被复用，generation在整个Poller内递增
+    std::unordered_map<int, Registration> registrations_;
+    std::vector<int> fired_; // 上一轮触发过、需要重新注册的fd
+
+    uint64_t nextToken_;
+    std::unordered_map<uint64_t, CompletionCallback> completionHandlers_;
+    std::vector<struct io_uring_cqe> completions_; // 本轮收到、等待派发的完成事件
+    Channel completionChannel_;
+    std::unique_ptr<IoUringBufferRing> bufferRing_;
+    bool bufferRingFailed_;
+};
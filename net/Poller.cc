@@ -3,7 +3,11 @@
 #include "Channel.h"
 #include "EventLoop.h"
 #include "EPollPoller.h"
+#include "IoUringPoller.h"
+#include "Logger.h"
 #include "PollPoller.h"
+#include <cstdlib>
+#include <cstring>
 #include <unistd.h>
 
 Poller::Poller(EventLoop *loop) : ownerLoop_(loop) {}
@@ -12,9 +16,26 @@ Poller::~Poller() = default;
 
 void Poller::assertInLoopThread() const { ownerLoop_->assertInLoopThread(); }
 
+/**
+ * 通过环境变量 POLLER_BACKEND 选择实现：epoll（默认）、poll、io_uring
+ * io_uring 初始化失败（内核不支持或被禁用）时退回 epoll
+ */
 Poller *Poller::newDefaultPoller(EventLoop *loop)
 {
 #if defined(__linux__)
+    const char *backend = ::getenv("POLLER_BACKEND");
+    if (backend != nullptr && ::strcmp(backend, "poll") == 0)
+    {
+        return new PollPoller(loop);
+    }
+    if (backend != nullptr && ::strcmp(backend, "io_uring") == 0)
+    {
+        IoUringPoller *poller = new IoUringPoller(loop);
+        if (poller->valid())
+            return poller;
+        delete poller;
+        LOG_WARN << "io_uring unavailable, fall back to epoll";
+    }
     return new EPollPoller(loop);
 #else
     return new PollPoller(loop);
@@ -90,4 +90,28 @@ void Socket::setKeepAlive(bool on)
     // 这对于检测网络中失效的对等方非常有用。
     int optval = on ? 1 : 0;
     ::setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof(optval));
-}
\ No newline at end of file
+}
+
+void Socket::setLinger(bool on, int seconds)
+{
+    // SO_LINGER 控制 close 时如何处理发送缓冲区中还没有发出的数据，
+    // 超时为0时 close 立即发RST、丢弃这些数据，不进入TIME_WAIT。
+    struct linger optval;
+    optval.l_onoff = on ? 1 : 0;
+    optval.l_linger = seconds;
+    ::setsockopt(sockfd_, SOL_SOCKET, SO_LINGER, &optval, sizeof(optval));
+}
+
+bool Socket::setZeroCopy(bool on)
+{
+    // SO_ZEROCOPY 允许 send 时带上 MSG_ZEROCOPY，由内核直接引用用户页发送，
+    // 发送完成后通过套接字的错误队列通知应用程序释放缓冲区。
+    int optval = on ? 1 : 0;
+    return ::setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY, &optval, sizeof(optval)) == 0;
+}
+bool Socket::setBusyPoll(int usec)
+{
+    // SO_BUSY_POLL 让阻塞读/poll在没有数据时先在网卡队列上忙等最多usec微秒，
+    // 减少中断和软中断调度带来的延迟，代价是CPU占用。
+    return ::setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec)) == 0;
+}
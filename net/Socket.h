@@ -25,6 +25,12 @@ public:
     void setReuseAddr(bool on);
     void setReusePort(bool on);
     void setKeepAlive(bool on);
+    // SO_LINGER：on且seconds为0时close直接发RST，丢弃还没有发出的数据
+    void setLinger(bool on, int seconds);
+    // 成功返回true，内核不支持SO_ZEROCOPY时返回false
+    bool setZeroCopy(bool on);
+    // 成功返回true，超过 net.core.busy_read 需要 CAP_NET_ADMIN
+    bool setBusyPoll(int usec);
 
 private:
     const int sockfd_;
@@ -2,11 +2,17 @@
 
 #include "Channel.h"
 #include "EventLoop.h"
+#include "IoUringPoller.h"
+#include "LogLimiter.h"
 #include "Logger.h"
 #include "Socket.h"
 #include "Timestamp.h"
 
 #include <cassert>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
 
 static EventLoop *CHECK_NOTNULL(EventLoop *loop)
 {
@@ -20,7 +26,9 @@ static EventLoop *CHECK_NOTNULL(EventLoop *loop)
 TcpConnection::TcpConnection(EventLoop *loop, const std::string &nameArg, int sockfd, const InetAddress &localAddr,
                              const InetAddress &peerAddr)
     : loop_(CHECK_NOTNULL(loop)), name_(nameArg), state_(KConnecting), socket_(new Socket(sockfd)),
-      channel_(new Channel(loop, sockfd)), localAddr_(localAddr), peerAddr_(peerAddr)
+      channel_(new Channel(loop, sockfd)), localAddr_(localAddr), peerAddr_(peerAddr), highWaterMark_(64 * 1024 * 1024),
+      splicing_(false), spliceEof_(false), splicePipe_{-1, -1}, splicePipeBytes_(0), ioUringRequested_(false),
+      ioUring_(nullptr), ioUringToken_(0), recvArmed_(false), recvStopped_(false), sendInFlight_(false)
 {
     LOG_DEBUG << "TcpConnection::ctor[" << name_ << "] at " << this << " fd=" << sockfd;
     channel_->setReadCallback([this](Timestamp receiveTime) { this->handleRead(receiveTime); });
@@ -32,6 +40,11 @@ TcpConnection::TcpConnection(EventLoop *loop, const std::string &nameArg, int so
 TcpConnection::~TcpConnection()
 {
     LOG_DEBUG << "TcpConnection::dtor[" << name_ << "] at " << this << " fd=" << channel_->fd();
+    if (splicePipe_[0] >= 0)
+    {
+        ::close(splicePipe_[0]);
+        ::close(splicePipe_[1]);
+    }
 }
 
 void TcpConnection::connectEstablished()
@@ -39,13 +52,21 @@ void TcpConnection::connectEstablished()
     loop_->assertInLoopThread();
     assert(state_ == KConnecting);
     setState(KConnected);
-    channel_->enableReading();
+    if (ioUringRequested_)
+        startIoUring();
+    if (ioUring_ == nullptr)
+        channel_->enableReading();
 
     connectionCallback_(shared_from_this());
 }
 
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
+    if (splicing_)
+    {
+        handleSpliceRead();
+        return;
+    }
     int savedErrno = 0;
     ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
     if (n > 0)
@@ -55,7 +76,7 @@ void TcpConnection::handleRead(Timestamp receiveTime)
     else
     {
         errno = savedErrno;
-        LOG_ERROR << "TcpConnection::handleRead";
+        LOG_ERROR_RATELIMIT(10) << "TcpConnection::handleRead errno=" << savedErrno;
         handleError();
     }
 }
@@ -67,12 +88,43 @@ void TcpConnection::handleClose()
     assert(state_ == KConnected || state_ == KDisconnecting);
     // 析构关闭fd，方便定位没有析构的TcpConnection
     channel_->disableAll();
+    if (ioUring_ != nullptr && !recvStopped_)
+    {
+        recvStopped_ = true;
+        if (recvArmed_)
+        {
+            // 取消multishot recv，它的最后一个完成事件到来之前连接一直被ioUringSelf_持有
+            struct io_uring_sqe *sqe = ioUring_->getSqe();
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = IoUringPoller::completionUserData(ioUringToken_, kRecvOp);
+            sqe->user_data = IoUringPoller::completionUserData(ioUringToken_, kCancelOp);
+        }
+    }
+    if (splicing_)
+    {
+        // 断开和sink的关联，sink可写时不再回调到这里
+        if (TcpConnectionPtr sink = spliceSink_.lock())
+            sink->spliceSource_.reset();
+        spliceSink_.reset();
+        splicing_ = false;
+    }
     // 回调要放在最后，否则channel_可能已经被销毁
     closeCallback_(shared_from_this());
 }
 
 void TcpConnection::handleError()
 {
+    if (outputBuffer_.zeroCopyThreshold() > 0)
+    {
+        // MSG_ZEROCOPY的完成通知通过错误队列上报，同样表现为POLLERR
+        int savedErrno = 0;
+        if (outputBuffer_.handleZeroCopyCompletions(channel_->fd(), &savedErrno) < 0)
+        {
+            errno = savedErrno;
+            LOG_ERROR << "TcpConnection::handleError name:" << name_.c_str() << " read MSG_ERRQUEUE";
+        }
+    }
     int optval;
     socklen_t optlen = sizeof optval;
     int err = 0;
@@ -84,7 +136,9 @@ void TcpConnection::handleError()
     {
         err = optval;
     }
-    LOG_ERROR << "TcpConnection::handleError name:" << name_.c_str() << "- SO_ERROR:%" << err;
+    if (err == 0 && outputBuffer_.zeroCopyThreshold() > 0)
+        return; // 只是零拷贝完成通知
+    LOG_ERROR_RATELIMIT(10) << "TcpConnection::handleError name:" << name_.c_str() << "- SO_ERROR:%" << err;
 }
 
 void TcpConnection::connectDestroyed()
@@ -96,6 +150,40 @@ void TcpConnection::connectDestroyed()
     connectionCallback_(shared_from_this());
 
     loop_->removeChannel(channel_.get());
+
+    // 已经发出的零拷贝slice还被内核引用，不能随连接一起释放
+    outputBuffer_.retrieveAll();
+    if (outputBuffer_.zeroCopyPendingBytes() > 0)
+    {
+        // fd要保持打开才能读错误队列，先关闭写方向，FIN照常排在数据之后
+        socket_->shutdownWrite();
+        lingerZeroCopy(kZeroCopyLingerPolls);
+    }
+}
+
+void TcpConnection::lingerZeroCopy(int remainingPolls)
+{
+    loop_->assertInLoopThread();
+    int savedErrno = 0;
+    if (outputBuffer_.handleZeroCopyCompletions(socket_->fd(), &savedErrno) < 0)
+    {
+        errno = savedErrno;
+        LOG_ERROR_RATELIMIT(10) << "TcpConnection::lingerZeroCopy [" << name_ << "] read MSG_ERRQUEUE";
+    }
+    if (outputBuffer_.zeroCopyPendingBytes() == 0)
+        return;
+    if (remainingPolls == 0)
+    {
+        // 对端一直不确认：RST关闭时内核丢弃发送队列，不再读这些内存
+        LOG_WARN << "TcpConnection::lingerZeroCopy [" << name_ << "] " << outputBuffer_.zeroCopyPendingBytes()
+                 << " bytes still not completed, reset connection";
+        socket_->setLinger(true, 0);
+        return;
+    }
+    // 定时器持有连接，析构时才关闭fd、释放slice
+    loop_->runAfter(kZeroCopyPollInterval, [self = shared_from_this(), remainingPolls]() {
+        self->lingerZeroCopy(remainingPolls - 1);
+    });
 }
 
 void TcpConnection::shutdown()
@@ -110,7 +198,7 @@ void TcpConnection::shutdown()
 void TcpConnection::shutdownInLoop()
 {
     loop_->assertInLoopThread();
-    if (!channel_->isWriting())
+    if (!channel_->isWriting() && !sendInFlight_)
         socket_->shutdownWrite();
 }
 
@@ -121,15 +209,18 @@ void TcpConnection::send(std::string message)
         if (loop_->isInLoopThread())
             sendInLoop(std::move(message));
         else
-            loop_->runInLoop([this, msg = std::move(message)]() { this->sendInLoop(std::move(msg)); });
+            loop_->runInLoop([this, msg = std::move(message)]() mutable { this->sendInLoop(std::move(msg)); });
     }
 }
 
-void TcpConnection::sendInLoop(const std::string &message)
+void TcpConnection::sendInLoop(std::string &&message)
 {
     loop_->assertInLoopThread();
     ssize_t nwrote = 0;
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+    // 零拷贝的消息也要交给outputBuffer_，由它负责在完成通知到来前持有内存
+    bool zeroCopy = outputBuffer_.zeroCopyThreshold() > 0 && message.size() >= outputBuffer_.zeroCopyThreshold();
+    // io_uring模式下不直接write，统一由sendmsg请求发送
+    if (ioUring_ == nullptr && !channel_->isWriting() && outputBuffer_.readableBytes() == 0 && !zeroCopy)
     {
         nwrote = ::write(channel_->fd(), message.data(), message.size());
         if (nwrote >= 0)
@@ -153,22 +244,102 @@ void TcpConnection::sendInLoop(const std::string &message)
     if (static_cast<size_t>(nwrote) < message.size())
     {
         size_t remaining = message.size() - nwrote;
-        size_t oldLen = outputBuffer_.readableBytes();
+        size_t oldLen = pendingOutputBytes();
         if (oldLen + remaining >= highWaterMark_ && oldLen < highWaterMark_ && highWaterMarkCallback_)
             loop_->queueInLoop([weakSelf = shared_from_this(), oldLen, remaining]() { weakSelf->highWaterMarkCallback_(weakSelf,  oldLen + remaining);});
-        outputBuffer_.append(message.data() + nwrote, message.size() - nwrote);
-        if (!channel_->isWriting())
+        if (nwrote == 0)
+            outputBuffer_.append(std::move(message)); // 大消息直接挂到链上，不再拷贝
+        else
+            outputBuffer_.append(message.data() + nwrote, remaining);
+        if (ioUring_ != nullptr)
+            flushIoUring();
+        else if (!channel_->isWriting())
             channel_->enableWriting(); // level-triggered , 只要 socket 可写，就会持续触发写事件
     }
 }
 
+void TcpConnection::sendFile(int fd, off_t offset, size_t length)
+{
+    if (state_ == KConnected)
+    {
+        // 文件可能要到若干次可写事件之后才发完，持有一份独立的fd避免调用者提前关闭
+        int dupfd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (dupfd < 0)
+        {
+            LOG_ERROR << "TcpConnection::sendFile dup fd=" << fd;
+            return;
+        }
+        if (loop_->isInLoopThread())
+            sendFileInLoop(dupfd, offset, length);
+        else
+            loop_->runInLoop([this, dupfd, offset, length]() { this->sendFileInLoop(dupfd, offset, length); });
+    }
+}
+
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t length)
+{
+    loop_->assertInLoopThread();
+    ssize_t nwrote = 0;
+    // 输出缓冲区为空时直接sendfile，否则排到已有数据的后面
+    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+    {
+        off_t off = offset;
+        nwrote = ::sendfile(channel_->fd(), fd, &off, length);
+        if (nwrote >= 0)
+        {
+            if (static_cast<size_t>(nwrote) < length)
+                LOG_TRACE << "I am going to send more file data";
+            else if (writeCompleteCallback_)
+                loop_->queueInLoop([weakSelf = shared_from_this()]() { weakSelf->writeCompleteCallback_(weakSelf); });
+        }
+        else
+        {
+            nwrote = 0;
+            if (errno != EWOULDBLOCK)
+            {
+                LOG_ERROR << "TcpConnection::sendFileInLoop";
+            }
+        }
+    }
+
+    assert(nwrote >= 0);
+    if (static_cast<size_t>(nwrote) < length)
+    {
+        size_t remaining = length - nwrote;
+        size_t oldLen = pendingOutputBytes();
+        if (oldLen + remaining >= highWaterMark_ && oldLen < highWaterMark_ && highWaterMarkCallback_)
+            loop_->queueInLoop([weakSelf = shared_from_this(), oldLen, remaining]() { weakSelf->highWaterMarkCallback_(weakSelf,  oldLen + remaining);});
+        outputBuffer_.appendFile(fd, offset + nwrote, remaining); // fd交给outputBuffer_，发完后关闭
+        if (ioUring_ != nullptr)
+            flushIoUring(); // 等前面的sendmsg完成后再走可写事件发送文件段
+        else if (!channel_->isWriting())
+            channel_->enableWriting();
+    }
+    else
+    {
+        ::close(fd);
+    }
+}
+
 void TcpConnection::handleWrite()
 {
     loop_->assertInLoopThread();
     if (channel_->isWriting())
     {
-        ssize_t n = ::write(channel_->fd(), outputBuffer_.peek(), outputBuffer_.readableBytes());
-        if (n > 0)
+        if (outputBuffer_.readableBytes() == 0)
+        {
+            // 只是在等splice源的管道数据
+            channel_->disableWriting();
+            if (TcpConnectionPtr source = spliceSource_.lock())
+                source->flushSplicePipe(); // 管道还没排空时会重新enableWriting
+            if (!channel_->isWriting() && state_ == KDisconnecting)
+                shutdownInLoop();
+            return;
+        }
+        int savedErrno = 0;
+        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
+        // n == 0 说明链上只剩被截断的文件段，已被丢弃，同样视为发送完毕
+        if (n > 0 || (n == 0 && outputBuffer_.readableBytes() == 0))
         {
             outputBuffer_.retrieve(n);
             if (outputBuffer_.readableBytes() == 0)
@@ -181,6 +352,9 @@ void TcpConnection::handleWrite()
                 {
                     shutdownInLoop();
                 }
+                // 输出缓冲区排空后才轮到splice管道里的数据
+                if (TcpConnectionPtr source = spliceSource_.lock())
+                    source->flushSplicePipe();
             }
             else
             {
@@ -189,6 +363,7 @@ void TcpConnection::handleWrite()
         }
         else
         {
+            errno = savedErrno;
             LOG_ERROR << "TcpConnection::handleWrite";
         }
     }
@@ -198,6 +373,302 @@ void TcpConnection::handleWrite()
     }
 }
 
+void TcpConnection::startSplice(const TcpConnectionPtr &sink)
+{
+    loop_->runInLoop([self = shared_from_this(), sink]() { self->startSpliceInLoop(sink); });
+}
+
+void TcpConnection::startSpliceInLoop(const TcpConnectionPtr &sink)
+{
+    loop_->assertInLoopThread();
+    if (ioUring_ != nullptr || sink->ioUring_ != nullptr)
+    {
+        LOG_ERROR << "TcpConnection::startSplice [" << name_ << "] -> [" << sink->name()
+                  << "] splice is not supported in io_uring mode";
+        return;
+    }
+    if (sink->getLoop() != loop_)
+    {
+        LOG_ERROR << "TcpConnection::startSplice [" << name_ << "] -> [" << sink->name()
+                  << "] connections must be in the same EventLoop";
+        return;
+    }
+    if (splicing_ || state_ != KConnected)
+        return;
+
+    if (::pipe2(splicePipe_, O_NONBLOCK | O_CLOEXEC) < 0)
+    {
+        LOG_ERROR << "TcpConnection::startSplice pipe2";
+        return;
+    }
+    ::fcntl(splicePipe_[1], F_SETPIPE_SZ, kSplicePipeSize); // 失败时保持默认的64K
+    splicing_ = true;
+    spliceSink_ = sink;
+    sink->spliceSource_ = shared_from_this();
+
+    // 开始splice之前已经读进来的数据先按普通方式转发
+    if (inputBuffer_.readableBytes() > 0)
+        sink->send(inputBuffer_.retrieveAllAsString());
+}
+
+void TcpConnection::handleSpliceRead()
+{
+    loop_->assertInLoopThread();
+    TcpConnectionPtr sink = spliceSink_.lock();
+    if (!sink || !sink->connected())
+    {
+        // 对端已经断开，没有继续转发的必要
+        handleClose();
+        return;
+    }
+
+    ssize_t n = ::splice(channel_->fd(), nullptr, splicePipe_[1], nullptr, kSplicePipeSize,
+                         SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n > 0)
+    {
+        splicePipeBytes_ += n;
+        flushSplicePipe();
+    }
+    else if (n == 0)
+    {
+        spliceEof_ = true;
+        channel_->disableReading();
+        flushSplicePipe();
+    }
+    else if (errno != EAGAIN)
+    {
+        LOG_ERROR << "TcpConnection::handleSpliceRead";
+        handleError();
+    }
+}
+
+// 尽量把管道里的数据splice到sink；sink写不动时停止读本连接，并让sink在可写时回调这里
+void TcpConnection::flushSplicePipe()
+{
+    loop_->assertInLoopThread();
+    TcpConnectionPtr sink = spliceSink_.lock();
+    if (!sink)
+        return;
+
+    // sink的输出缓冲区里还有普通数据，必须等它先发完
+    if (sink->outputBuffer_.readableBytes() == 0)
+    {
+        while (splicePipeBytes_ > 0)
+        {
+            ssize_t n = ::splice(splicePipe_[0], nullptr, sink->channel_->fd(), nullptr, splicePipeBytes_,
+                                 SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n > 0)
+            {
+                splicePipeBytes_ -= n;
+            }
+            else
+            {
+                if (errno != EAGAIN)
+                {
+                    LOG_ERROR << "TcpConnection::flushSplicePipe";
+                    splicePipeBytes_ = 0; // sink出错，丢弃管道中的数据
+                }
+                break;
+            }
+        }
+    }
+
+    if (splicePipeBytes_ > 0)
+    {
+        if (channel_->isReading())
+            channel_->disableReading();
+        if (!sink->channel_->isWriting())
+            sink->channel_->enableWriting();
+    }
+    else if (spliceEof_)
+    {
+        // 这个方向的数据已经全部送达：半关闭sink，并解除双方的关联
+        sink->spliceSource_.reset();
+        spliceSink_.reset();
+        sink->shutdown();
+        // 反方向也已经结束（或者本来就是单向转发）才关闭本连接，否则等反方向结束后对端关闭
+        if (spliceSource_.expired())
+        {
+            if (outputBuffer_.readableBytes() == 0)
+                handleClose();
+            else
+                shutdown(); // 输出缓冲区发完后半关闭，收到POLLHUP时再关闭
+        }
+    }
+    else if (!channel_->isReading())
+    {
+        // 管道排空，恢复读数据源（本连接可能已被反方向shutdown，此时仍要继续转发）
+        channel_->enableReading();
+    }
+}
+
 void TcpConnection::setTcpNoDelay(bool on) { socket_->setTcpNoDelay(on); }
 
-void TcpConnection::setKeepAlive(bool on) { socket_->setKeepAlive(on); }
\ No newline at end of file
+void TcpConnection::setKeepAlive(bool on) { socket_->setKeepAlive(on); }
+
+void TcpConnection::setBusyPoll(int usec)
+{
+    if (!socket_->setBusyPoll(usec))
+    {
+        LOG_WARN << "TcpConnection::setBusyPoll [" << name_ << "] SO_BUSY_POLL failed errno=" << errno;
+    }
+}
+
+void TcpConnection::enableZeroCopy(size_t threshold)
+{
+    loop_->runInLoop([self = shared_from_this(), threshold]() { self->enableZeroCopyInLoop(threshold); });
+}
+
+void TcpConnection::enableZeroCopyInLoop(size_t threshold)
+{
+    loop_->assertInLoopThread();
+    if (threshold == 0)
+        threshold = kDefaultZeroCopyThreshold;
+    if (!socket_->setZeroCopy(true))
+    {
+        LOG_WARN << "TcpConnection::enableZeroCopy [" << name_ << "] SO_ZEROCOPY not supported, keep copying";
+        return;
+    }
+    outputBuffer_.setZeroCopyThreshold(threshold);
+}
+void TcpConnection::startIoUring()
+{
+    IoUringPoller *poller = loop_->ioUringPoller();
+    if (poller == nullptr || poller->bufferRing() == nullptr)
+    {
+        LOG_WARN << "TcpConnection::startIoUring [" << name_ << "] io_uring unavailable, use readiness mode";
+        return;
+    }
+    ioUring_ = poller;
+    ioUringToken_ = ioUring_->addCompletionHandler(
+        [this](const struct io_uring_cqe &cqe, Timestamp receiveTime) { this->handleIoUringCompletion(cqe, receiveTime); });
+    armIoUringRecv();
+}
+
+void TcpConnection::armIoUringRecv()
+{
+    struct io_uring_sqe *sqe = ioUring_->getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = channel_->fd();
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = ioUring_->bufferRing()->groupId();
+    sqe->user_data = IoUringPoller::completionUserData(ioUringToken_, kRecvOp);
+    recvArmed_ = true;
+    if (!ioUringSelf_)
+        ioUringSelf_ = shared_from_this();
+}
+
+// 把输出链头部的内存分段用一个sendmsg提交；链头是文件段或零拷贝slice时交给可写事件路径(handleWrite)
+void TcpConnection::flushIoUring()
+{
+    if (ioUringToken_ == 0 || recvStopped_ || sendInFlight_ || channel_->isWriting() ||
+        outputBuffer_.readableBytes() == 0)
+        return;
+    int iovcnt = outputBuffer_.peekIovec(sendIov_, kMaxSendIov);
+    if (iovcnt == 0)
+    {
+        channel_->enableWriting();
+        return;
+    }
+    ::memset(&sendMsg_, 0, sizeof(sendMsg_));
+    sendMsg_.msg_iov = sendIov_;
+    sendMsg_.msg_iovlen = iovcnt;
+
+    struct io_uring_sqe *sqe = ioUring_->getSqe();
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = channel_->fd();
+    sqe->addr = reinterpret_cast<uint64_t>(&sendMsg_);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = IoUringPoller::completionUserData(ioUringToken_, kSendOp);
+    sendInFlight_ = true;
+    if (!ioUringSelf_)
+        ioUringSelf_ = shared_from_this();
+}
+
+void TcpConnection::handleIoUringCompletion(const struct io_uring_cqe &cqe, Timestamp receiveTime)
+{
+    loop_->assertInLoopThread();
+    TcpConnectionPtr guard(shared_from_this()); // 下面可能释放ioUringSelf_
+    switch (IoUringPoller::completionOp(cqe))
+    {
+    case kRecvOp:
+        handleIoUringRecv(cqe, receiveTime);
+        break;
+    case kSendOp:
+        handleIoUringSend(cqe);
+        break;
+    default:
+        break;
+    }
+    // 连接已经关闭且没有请求在内核中，可以释放了
+    if (!recvArmed_ && !sendInFlight_)
+    {
+        ioUring_->removeCompletionHandler(ioUringToken_);
+        ioUringToken_ = 0;
+        ioUringSelf_.reset();
+    }
+}
+
+void TcpConnection::handleIoUringRecv(const struct io_uring_cqe &cqe, Timestamp receiveTime)
+{
+    if (!(cqe.flags & IORING_CQE_F_MORE))
+        recvArmed_ = false; // multishot已经结束，需要重新提交
+    if (cqe.res > 0)
+    {
+        IoUringBufferRing *bufRing = ioUring_->bufferRing();
+        uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        if (!recvStopped_)
+            inputBuffer_.append(bufRing->buffer(bid), cqe.res);
+        bufRing->recycle(bid); // 数据已经拷进inputBuffer_，立即归还
+        if (!recvStopped_)
+            messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    }
+    else if (cqe.res == 0)
+    {
+        if (!recvStopped_)
+            handleClose();
+    }
+    else if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED)
+    {
+        // -ENOBUFS: 缓冲区暂时被用完，重新提交即可
+        errno = -cqe.res;
+        LOG_ERROR << "TcpConnection::handleIoUringRecv errno=" << -cqe.res;
+        if (!recvStopped_)
+            handleClose();
+    }
+    if (!recvArmed_ && !recvStopped_)
+        armIoUringRecv();
+}
+
+void TcpConnection::handleIoUringSend(const struct io_uring_cqe &cqe)
+{
+    sendInFlight_ = false;
+    if (cqe.res == -EAGAIN || cqe.res == -EINTR)
+    {
+        flushIoUring(); // 数据还在outputBuffer_中，重新提交
+        return;
+    }
+    if (cqe.res < 0)
+    {
+        // 对端重置、管道断开等：连接已经不能再发送，和recv出错一样关闭，剩下的数据随连接丢弃
+        if (cqe.res != -ECANCELED)
+        {
+            errno = -cqe.res;
+            LOG_ERROR_RATELIMIT(10) << "TcpConnection::handleIoUringSend errno=" << -cqe.res;
+        }
+        if (!recvStopped_)
+            handleClose();
+        return;
+    }
+    outputBuffer_.retrieve(cqe.res);
+    if (outputBuffer_.readableBytes() > 0)
+    {
+        flushIoUring();
+        return;
+    }
+    if (writeCompleteCallback_)
+        loop_->queueInLoop([weakSelf = shared_from_this()]() { weakSelf->writeCompleteCallback_(weakSelf); });
+    if (state_ == KDisconnecting)
+        shutdownInLoop();
+}
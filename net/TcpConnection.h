@@ -4,14 +4,20 @@
 #include "InetAddress.h"
 #include "noncopyable.h"
 #include "Buffer.h"
+#include "ChainBuffer.h"
 #include <memory>
 #include <string>
 #include <functional>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
 class Channel;
 class EventLoop;
+class IoUringPoller;
 class Socket;
 class Timestamp;
+struct io_uring_cqe;
 
 class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnection>
 {
@@ -34,6 +40,11 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
 
     void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark) { highWaterMarkCallback_ = cb; highWaterMark_ = highWaterMark; }
 
+    // 完成式io_uring模式：recv/send本身通过io_uring提交（multishot recv + 内核提供缓冲区，sendmsg发送输出链），
+    // MessageCallback等回调的语义不变。必须在connectEstablished之前设置，loop不是io_uring Poller时退回普通模式
+    void setIoUringMode(bool on) { ioUringRequested_ = on; }
+    bool ioUringMode() const { return ioUring_ != nullptr; }
+
     // called when TcpServer accepts a new connection
     void connectEstablished(); // should be called only once
     //Internal use only
@@ -44,13 +55,45 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
 
     //建议输入右值引用
     void send(std::string message);
+    // 零拷贝发送文件的[offset, offset+length)，与之前send的数据保持先后顺序
+    // 内部会dup一份fd，调用者可以在返回后立即关闭自己的fd。Thread safe
+    void sendFile(int fd, off_t offset, size_t length);
     //Thread safe
     void shutdown();
 
+    // 把本连接收到的数据经由内核pipe用splice(2)直接转给sink，数据不经过用户态，MessageCallback不再被调用
+    // sink写不动时自动停止读本连接，腾出空间后再恢复（背压）；本连接读到EOF后对sink执行shutdown
+    // 两个连接必须属于同一个EventLoop，双向转发需要再调用一次 sink->startSplice(本连接)。Thread safe
+    void startSplice(const TcpConnectionPtr& sink);
+
     void setTcpNoDelay(bool on);
     void setKeepAlive(bool on);
+    // 设置socket的SO_BUSY_POLL，配合EventLoop::setBusyPoll使用
+    void setBusyPoll(int usec);
+
+    // 打开MSG_ZEROCOPY发送：之后用send(std::move(msg))交出所有权、且不小于threshold的消息不再拷贝，
+    // 内核发送完成（错误队列中的通知）之后才释放，连接关闭之后也要等到通知（最多30秒）；小消息仍然走拷贝路径。Thread safe
+    void enableZeroCopy(size_t threshold = kDefaultZeroCopyThreshold);
+    // 零拷贝发送的统计，在loop线程中调用
+    // 已经发出、还在等待内核完成通知的字节数，这部分内存仍被占用，和输出缓冲区一起计入高水位
+    size_t zeroCopyPendingBytes() const { return outputBuffer_.zeroCopyPendingBytes(); }
+    // 内核退化为拷贝发送的次数（例如发往本机回环地址）
+    uint64_t zeroCopyCopiedCount() const { return outputBuffer_.zeroCopyCopiedCount(); }
 
   private:
+    static const int kSplicePipeSize = 256 * 1024; // splice管道容量，也是单次splice的上限
+    static const size_t kDefaultZeroCopyThreshold = 32 * 1024; // 太小的消息零拷贝的页面锁定开销得不偿失
+    static constexpr double kZeroCopyPollInterval = 0.01; // 连接关闭后轮询零拷贝完成通知的间隔（秒）
+    static const int kZeroCopyLingerPolls = 3000;          // 最多等30秒，之后以RST关闭，内核随之丢弃引用slice的数据
+    static const int kMaxSendIov = 64; // io_uring模式下一次sendmsg最多提交的分段数
+
+    enum IoUringOp : uint8_t
+    {
+      kRecvOp,
+      kSendOp,
+      kCancelOp,
+    };
+
     enum StateE
     {
       KConnecting,
@@ -60,12 +103,28 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
     };
 
     void setState(StateE s) { state_ = s; }
+    // 高水位按占用的内存计算：输出缓冲区中还没发出的 + 零拷贝发出后还在等完成通知的
+    size_t pendingOutputBytes() const { return outputBuffer_.readableBytes() + outputBuffer_.zeroCopyPendingBytes(); }
     void handleRead(Timestamp receiveTime);
     void handleWrite();
     void handleClose();
     void handleError();
-    void sendInLoop(const std::string& message);
+    void sendInLoop(std::string&& message);
+    void sendFileInLoop(int fd, off_t offset, size_t length);
     void shutdownInLoop();
+    void startSpliceInLoop(const TcpConnectionPtr& sink);
+    void handleSpliceRead();
+    void flushSplicePipe();
+    void enableZeroCopyInLoop(size_t threshold);
+    // 连接已经销毁但内核还引用着零拷贝发出的slice：保持连接（fd和outputBuffer_）存活，
+    // 定时读取完成通知，全部到达之后释放
+    void lingerZeroCopy(int remainingPolls);
+    void startIoUring();
+    void armIoUringRecv();
+    void flushIoUring();
+    void handleIoUringCompletion(const struct io_uring_cqe &cqe, Timestamp receiveTime);
+    void handleIoUringRecv(const struct io_uring_cqe &cqe, Timestamp receiveTime);
+    void handleIoUringSend(const struct io_uring_cqe &cqe);
 
     EventLoop *loop_;
     std::string name_;
@@ -81,5 +140,22 @@ class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnec
     HighWaterMarkCallback highWaterMarkCallback_;//高水位回调
     size_t highWaterMark_;
     Buffer inputBuffer_;
-    Buffer outputBuffer_;
+    // 本连接作为splice数据源: socket -> splicePipe_ -> spliceSink_
+    bool splicing_;
+    bool spliceEof_;                           // 已经读到EOF，管道排空后关闭
+    int splicePipe_[2];
+    size_t splicePipeBytes_;                   // 管道中还没送到sink的字节数
+    std::weak_ptr<TcpConnection> spliceSink_;
+    std::weak_ptr<TcpConnection> spliceSource_; // 本连接作为sink时的数据源
+    ChainBuffer outputBuffer_; // 链式输出缓冲区，handleWrite中用writev一次发出多个块
+    // io_uring完成式I/O
+    bool ioUringRequested_;
+    IoUringPoller *ioUring_;        // 非空表示处于io_uring模式
+    uint64_t ioUringToken_;         // 完成事件回调的token，请求全部完成并关闭后注销
+    bool recvArmed_;                // multishot recv还挂在ring上
+    bool recvStopped_;              // 已经关闭，不再继续recv，也不再提交sendmsg
+    bool sendInFlight_;             // sendMsg_引用着outputBuffer_中的内存，完成前不能retrieve
+    struct msghdr sendMsg_;
+    struct iovec sendIov_[kMaxSendIov];
+    TcpConnectionPtr ioUringSelf_;  // 有请求在内核中时保持连接存活，避免fd和缓冲区被提前释放
 };
\ No newline at end of file
@@ -20,7 +20,8 @@ static EventLoop *CHECK_NOTNULL(EventLoop *loop)
 
 TcpServer::TcpServer(EventLoop *loop, const InetAddress &listenAddr)
     : loop_(CHECK_NOTNULL(loop)), name_(listenAddr.toIpPort()), acceptor_(new Acceptor(loop, listenAddr)),
-      started_(false), nextConnId_(1), threadPool_(new EventLoopThreadPool(loop))
+      highWaterMark_(64 * 1024 * 1024), started_(false), ioUringMode_(false), busyPollUs_(0),
+      socketBusyPollUs_(0), nextConnId_(1), threadPool_(new EventLoopThreadPool(loop))
 {
     acceptor_->setNewConnectionCallback(
         [this](int sockfd, const InetAddress &peerAddr){
@@ -40,12 +41,33 @@ void TcpServer::setThreadNum(int numThreads)
     threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setIoUringMode(bool on)
+{
+    ioUringMode_ = on;
+    acceptor_->setIoUringMode(on);
+}
+
+void TcpServer::setBusyPoll(int64_t maxSpinUs, int socketBusyPollUs)
+{
+    busyPollUs_ = maxSpinUs;
+    socketBusyPollUs_ = socketBusyPollUs;
+}
+
 void TcpServer::start()
 {
     if(!started_)
     {
         started_ = true;
         threadPool_->start();
+        if (busyPollUs_ > 0)
+        {
+            loop_->setBusyPoll(busyPollUs_);
+            for (EventLoop *ioLoop : threadPool_->getAllLoops())
+            {
+                if (ioLoop != loop_)
+                    ioLoop->setBusyPoll(busyPollUs_);
+            }
+        }
     }
     
     if(!acceptor_->listenning())
@@ -85,6 +107,9 @@ void TcpServer::newConnection(int sockfd, const InetAddress &peerAddr)
     conn->setMessageCallback(messageCallback_);
     conn->setWriteCompleteCallback(writeCompleteCallback_);
     conn->setHighWaterMarkCallback(highWaterMarkCallback_, highWaterMark_);
+    conn->setIoUringMode(ioUringMode_);
+    if (socketBusyPollUs_ > 0)
+        conn->setBusyPoll(socketBusyPollUs_);
     //不能用值传递conn，否则conn和lamdba相互引用，不会被析构
     conn->setCloseCallback(
         [this](const TcpConnectionPtr& conn) {
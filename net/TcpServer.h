@@ -32,6 +32,14 @@ class TcpServer : noncopyable
 
         void setThreadNum(int numThreads);
 
+        // 监听和所有连接改用io_uring完成式I/O（multishot accept/recv），需要POLLER_BACKEND=io_uring
+        // Not thread safe, 在start()之前调用
+        void setIoUringMode(bool on);
+
+        // baseLoop和所有IO loop开启忙轮询（见EventLoop::setBusyPoll），socketBusyPollUs > 0 时新连接同时设置SO_BUSY_POLL
+        // Not thread safe, 在start()之前调用
+        void setBusyPoll(int64_t maxSpinUs, int socketBusyPollUs = 0);
+
     private:
         //Not thread safe but in loop
         void newConnection(int sockfd, const InetAddress& peerAddr);
@@ -51,6 +59,9 @@ class TcpServer : noncopyable
         HighWaterMarkCallback highWaterMarkCallback_;
         size_t highWaterMark_;
         bool started_;
+        bool ioUringMode_;
+        int64_t busyPollUs_;
+        int socketBusyPollUs_;
         int nextConnId_;//always in loop thread;
         ConnectionMap connections_;
         std::unique_ptr<EventLoopThreadPool> threadPool_;
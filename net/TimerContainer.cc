@@ -0,0 +1,21 @@
+#include "TimerContainer.h"
+#include "TimerHeap.h"
+#include "TimerSet.h"
+#include "TimerWheel.h"
+
+#include <cstdlib>
+#include <cstring>
+
+TimerContainer *TimerContainer::newDefaultTimerContainer()
+{
+    const char *backend = ::getenv("TIMER_BACKEND");
+    if (backend != nullptr && ::strcmp(backend, "wheel") == 0)
+    {
+        return new TimerWheel();
+    }
+    if (backend != nullptr && ::strcmp(backend, "set") == 0)
+    {
+        return new TimerSet();
+    }
+    return new TimerHeap();
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "MonoTimestamp.h"
+#include "noncopyable.h"
+
+#include <stddef.h>
+#include <vector>
+
+class Timer;
+
+/**
+ * TimerQueue中存放定时器的数据结构，和Poller一样只规定接口，具体实现：
+ *   TimerHeap  按(到期时间, 加入顺序)排列的二叉堆，精确到微秒，插入/取消O(log n)
+ *   TimerSet   按(到期时间, 加入顺序)排序的std::set，精确到微秒，插入/取消O(log n)，每次插入分配一个节点
+ *   TimerWheel 分层时间轮，精度为一个tick（1ms），插入/取消O(1)
+ * 容器不拥有定时器，只通过Timer里的侵入式字段组织，堆和时间轮加入和取出都不分配内存（堆的数组扩容除外）
+ * 所有接口只在loop线程调用
+ */
+class TimerContainer : noncopyable
+{
+  public:
+    using TimerList = std::vector<Timer *>;
+
+    virtual ~TimerContainer() = default;
+
+    virtual void insert(Timer *timer) = 0;
+    // 定时器不在容器中（已经到期取出或者已经取消）时返回false
+    virtual bool erase(Timer *timer) = 0;
+    // 取出所有到期时间不晚于now的定时器，追加到expired
+    virtual void getExpired(MonoTimestamp now, TimerList *expired) = 0;
+    // 取出所有定时器，追加到timers
+    virtual void clear(TimerList *timers) = 0;
+    // 下一次需要处理的时间，容器为空时返回Timestamp::invalid()
+    virtual MonoTimestamp earliest() const = 0;
+    virtual size_t size() const = 0;
+
+    // 通过环境变量 TIMER_BACKEND 选择实现：heap（默认）、set、wheel
+    static TimerContainer *newDefaultTimerContainer();
+};
@@ -0,0 +1,109 @@
+#include "TimerHeap.h"
+#include "Timer.h"
+
+#include <cassert>
+
+TimerHeap::TimerHeap() : nextSequence_(0) {}
+
+bool TimerHeap::before(const Timer *a, const Timer *b)
+{
+    if (a->expiration_ != b->expiration_)
+        return a->expiration_ < b->expiration_;
+    return a->sequence_ < b->sequence_;
+}
+
+void TimerHeap::insert(Timer *timer)
+{
+    assert(timer->index_ < 0);
+    timer->sequence_ = nextSequence_++;
+    timer->index_ = static_cast<int>(heap_.size());
+    heap_.push_back(timer);
+    siftUp(heap_.size() - 1);
+}
+
+bool TimerHeap::erase(Timer *timer)
+{
+    if (timer->index_ < 0)
+        return false;
+    removeAt(static_cast<size_t>(timer->index_));
+    return true;
+}
+
+void TimerHeap::getExpired(MonoTimestamp now, TimerList *expired)
+{
+    while (!heap_.empty() && !(now < heap_.front()->expiration_))
+    {
+        expired->push_back(heap_.front());
+        removeAt(0);
+    }
+}
+
+void TimerHeap::clear(TimerList *timers)
+{
+    for (Timer *timer : heap_)
+    {
+        timer->index_ = -1;
+        timers->push_back(timer);
+    }
+    heap_.clear();
+}
+
+MonoTimestamp TimerHeap::earliest() const
+{
+    return heap_.empty() ? MonoTimestamp::invalid() : heap_.front()->expiration_;
+}
+
+void TimerHeap::removeAt(size_t index)
+{
+    Timer *timer = heap_[index];
+    Timer *last = heap_.back();
+    heap_.pop_back();
+    timer->index_ = -1;
+    if (index < heap_.size())
+    {
+        heap_[index] = last;
+        last->index_ = static_cast<int>(index);
+        // 换过来的元素可能比父节点小，也可能比子节点大
+        if (index > 0 && before(last, heap_[(index - 1) / 2]))
+            siftUp(index);
+        else
+            siftDown(index);
+    }
+}
+
+void TimerHeap::siftUp(size_t index)
+{
+    Timer *timer = heap_[index];
+    while (index > 0)
+    {
+        size_t parent = (index - 1) / 2;
+        if (!before(timer, heap_[parent]))
+            break;
+        heap_[index] = heap_[parent];
+        heap_[index]->index_ = static_cast<int>(index);
+        index = parent;
+    }
+    heap_[index] = timer;
+    timer->index_ = static_cast<int>(index);
+}
+
+void TimerHeap::siftDown(size_t index)
+{
+    Timer *timer = heap_[index];
+    size_t n = heap_.size();
+    for (;;)
+    {
+        size_t child = 2 * index + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && before(heap_[child + 1], heap_[child]))
+            ++child;
+        if (!before(heap_[child], timer))
+            break;
+        heap_[index] = heap_[child];
+        heap_[index]->index_ = static_cast<int>(index);
+        index = child;
+    }
+    heap_[index] = timer;
+    timer->index_ = static_cast<int>(index);
+}
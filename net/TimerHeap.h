@@ -0,0 +1,28 @@
+#pragma once
+#include "TimerContainer.h"
+
+#include <stdint.h>
+
+// 按(到期时间, 加入顺序)排列的二叉最小堆，Timer记录自己在数组中的下标，取消时直接定位
+class TimerHeap : public TimerContainer
+{
+  public:
+    TimerHeap();
+    ~TimerHeap() override = default;
+
+    void insert(Timer *timer) override;
+    bool erase(Timer *timer) override;
+    void getExpired(MonoTimestamp now, TimerList *expired) override;
+    void clear(TimerList *timers) override;
+    MonoTimestamp earliest() const override;
+    size_t size() const override { return heap_.size(); }
+
+  private:
+    static bool before(const Timer *a, const Timer *b);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void removeAt(size_t index);
+
+    std::vector<Timer *> heap_;
+    uint64_t nextSequence_;
+};
@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <errno.h>
 #include <string.h>
 #include <sys/timerfd.h>
@@ -16,60 +17,101 @@ using namespace std::placeholders;
 namespace detail
 {
 
-struct timespec toTimeSpec(Timestamp when)
+struct timespec toTimeSpec(MonoTimestamp when)
 {
     struct timespec ts;
-    int64_t microseconds = when.microSecondsSinceEpoch();
+    int64_t microseconds = when.microSeconds();
     ts.tv_sec = static_cast<time_t>(microseconds / Timestamp::kMicroSecondsPerSecond);
     ts.tv_nsec = static_cast<long>((microseconds % Timestamp::kMicroSecondsPerSecond) * 1000);
     return ts;
 }
 
-} // namespace detail
+bool useTimerfd()
+{
+    const char *source = ::getenv("TIMER_SOURCE");
+    return source == nullptr || ::strcmp(source, "poll") != 0;
+}
 
-TimerQueue::TimerQueue(EventLoop *loop)
-    : loop_(loop), timerfd_(::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
-      timerfdChannel_(loop_, timerfd_), callingExpiredTimers_(false)
+int createTimerfd(bool enabled)
 {
-    if (timerfd_ < 0)
+    if (!enabled)
+        return -1;
+    int timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd < 0)
     {
         LOG_FATAL << "Failed to create timerfd";
     }
-
-    timerfdChannel_.setReadCallback(std::bind(&TimerQueue::handleRead, this));
-    timerfdChannel_.enableReading();
+    return timerfd;
 }
 
-TimerQueue::~TimerQueue() { ::close(timerfd_); }
+} // namespace detail
 
-TimerId TimerQueue::addTimer(const Timer::TimerCallback &cb, Timestamp when, double interval)
+TimerQueue::TimerQueue(EventLoop *loop)
+    : loop_(loop), useTimerfd_(detail::useTimerfd()), timerfd_(detail::createTimerfd(useTimerfd_)),
+      timerfdChannel_(loop_, timerfd_), timers_(TimerContainer::newDefaultTimerContainer()),
+      callingExpiredTimers_(false), slackUs_(0), timerfdUpdates_(0), timerfdUpdatesSaved_(0), wakeups_(0),
+      timersFired_(0)
 {
+    if (useTimerfd_)
+    {
+        timerfdChannel_.setReadCallback(std::bind(&TimerQueue::handleRead, this));
+        timerfdChannel_.enableReading();
+    }
+}
 
-    std::shared_ptr<Timer> timer = std::make_shared<Timer>(cb, when, interval);
+TimerQueue::~TimerQueue()
+{
+    TimerList timers;
+    timers_->clear(&timers);
+    for (Timer *timer : timers)
+        destroy(timer);
+    if (timerfd_ >= 0)
+        ::close(timerfd_);
+}
+
+TimerId TimerQueue::addTimer(Timer::TimerCallback cb, MonoTimestamp when, double interval)
+{
+    Timer *timer = pool_.create(std::move(cb), when, interval);
+    TimerId timerId(timer, pool_.generation(timer));
 
     loop_->runInLoop([this, timer]() {
         this->addTimerInLoop(timer);
     });
 
-    return TimerId(timer);
+    return timerId;
 }
 
-void TimerQueue::addTimerInLoop(const std::shared_ptr<Timer>& timer)
+void TimerQueue::addTimerInLoop(Timer *timer)
 {
     loop_->assertInLoopThread();
+    // 跨线程添加时，加入之前就可能已经被取消或者延期
+    if (timer->canceled())
+    {
+        destroy(timer);
+        return;
+    }
+    timer->setRescheduled(false);
     bool earliestChanged = insert(timer);
 
     if (earliestChanged)
     {
-        updateTimerFd(timer->expiration());
+        rearm();
     }
 
 }
 
+Timer *TimerQueue::lookup(TimerId timerId) const
+{
+    Timer *timer = timerId.timer();
+    if (timer == nullptr || pool_.generation(timer) != timerId.generation())
+        return nullptr;
+    return timer;
+}
+
 void TimerQueue::handleRead()
 {
     loop_->assertInLoopThread();
-    Timestamp now = Timestamp::now();
+    MonoTimestamp now = loop_->now();
 
     uint64_t one;
     ssize_t n = ::read(timerfd_, &one, sizeof(one));
@@ -77,96 +119,141 @@ void TimerQueue::handleRead()
     {
         LOG_ERROR << "TimerQueue::handleRead() reads " << n << " bytes instead of 8";
     }
+    armedExpiration_ = MonoTimestamp::invalid(); // timerfd是单次的，触发后需要重新设置
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
+    runExpired(now);
+}
 
-    std::vector<Entry> expired = getExpired(now);
-
-    callingExpiredTimers_ = true;
-    cancelingTimers_.clear();
-
-    for (const auto &it : expired)
-    {
-        it.second->run(); // 执行回调
-    }
-    
-
-    reset(expired, now);
+int TimerQueue::pollTimeoutMs(int maxMs) const
+{
+    if (useTimerfd_)
+        return maxMs;
+    MonoTimestamp earliest = timers_->earliest();
+    if (earliest == MonoTimestamp::invalid())
+        return maxMs;
+    int64_t expiration = earliest.microSeconds();
+    // 和timerfd模式一样把唤醒时间对齐到slackUs_的整数倍
+    if (slackUs_ > 0)
+        expiration = (expiration + slackUs_ - 1) / slackUs_ * slackUs_;
+    // 处理完本轮事件后时间已经过去一些，重新读时钟（vDSO，不陷入内核）
+    int64_t delta = expiration - MonoTimestamp::now().microSeconds();
+    if (delta <= 0)
+        return 0;
+    // 向上取整到毫秒，poll超时返回时最早的定时器一定已经到期
+    int64_t timeoutMs = (delta + 999) / 1000;
+    return timeoutMs < maxMs ? static_cast<int>(timeoutMs) : maxMs;
+}
 
-    callingExpiredTimers_ = false;
-    cancelingTimers_.clear();
+void TimerQueue::processExpired()
+{
+    loop_->assertInLoopThread();
+    if (useTimerfd_)
+        return;
+    MonoTimestamp now = loop_->now();
+    MonoTimestamp earliest = timers_->earliest();
+    if (earliest == MonoTimestamp::invalid() || now < earliest)
+        return;
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
+    runExpired(now);
 }
 
-std::vector<TimerQueue::Entry> TimerQueue::getExpired(Timestamp now)
+void TimerQueue::runExpired(MonoTimestamp now)
 {
-    std::vector<Entry> expired;
+    // move out all expired timers
+    expired_.clear();
+    timers_->getExpired(now, &expired_);
+    timersFired_.fetch_add(expired_.size(), std::memory_order_relaxed);
 
-    Entry sentry = std::make_pair(now, std::shared_ptr<Timer>(nullptr));
+    callingExpiredTimers_ = true;
 
-    auto end = timers_.lower_bound(sentry);
-    assert(end == timers_.end() || now < end->first);
+    for (Timer *timer : expired_)
+    {
+        if (!timer->canceled()) // 可能被同一批中先执行的回调取消
+            timer->run(); // 执行回调
+    }
 
-    expired.assign(timers_.begin(), end);
-    timers_.erase(timers_.begin(), end);
+    reset(expired_, now);
 
-    return expired;
+    callingExpiredTimers_ = false;
 }
 
-void TimerQueue::reset(const std::vector<Entry> &expired, Timestamp now)
+void TimerQueue::reset(const TimerList &expired, MonoTimestamp now)
 {
-    Timestamp nextExpire = Timestamp::invalid();
-    for (const auto &it : expired)
+    for (Timer *timer : expired)
     {
-        std::shared_ptr<Timer> timer = it.second;
-        if(cancelingTimers_.count(timer))
+        if (timer->canceled())
         {
             LOG_TRACE << "Timer was canceled during callback, not re-adding";
-            timer->cancel();
+            destroy(timer);
         }
-        if (timer->repeat())
+        else if (timer->rescheduled())
+        {
+            timer->setRescheduled(false);
+            insert(timer);
+        }
+        else if (timer->repeat())
         {
             timer->restart(now);
             insert(timer);
         }
+        else
+        {
+            destroy(timer);
+        }
     }
-    if (!timers_.empty())
-    {
-        nextExpire = timers_.begin()->first;
-    }
+    rearm();
+}
 
-    if (nextExpire != Timestamp::invalid())
-    {
-        updateTimerFd(nextExpire);
-    }
+bool TimerQueue::insert(Timer *timer)
+{
+    MonoTimestamp when = timer->expiration();
+    LOG_TRACE << "Adding timer at " << when.microSeconds() << " Now is " << MonoTimestamp::now().microSeconds();
+
+    // 时间轮按tick取整，最早的唤醒时间以容器给出的为准
+    MonoTimestamp before = timers_->earliest();
+    timers_->insert(timer);
+    MonoTimestamp after = timers_->earliest();
+    return before == MonoTimestamp::invalid() || after < before;
 }
 
-bool TimerQueue::insert(std::shared_ptr<Timer> timer)
+void TimerQueue::setSlack(int64_t slackUs)
 {
-    Timestamp when = timer->expiration();
-    LOG_TRACE << "Adding timer at " << when.secondsSinceEpoch() << " Now is " << Timestamp::now().secondsSinceEpoch();
-    bool earliestChanged = false;
+    loop_->assertInLoopThread();
+    slackUs_ = slackUs > 0 ? slackUs : 0;
+}
 
-    auto it = timers_.begin();
-    if (it == timers_.end() || when < it->first)
+void TimerQueue::rearm()
+{
+    // poll模式下每轮poll之前重新计算超时，不需要设置什么
+    if (!useTimerfd_)
+        return;
+    MonoTimestamp earliest = timers_->earliest();
+    if (earliest == MonoTimestamp::invalid())
+        return;
+    int64_t expiration = earliest.microSeconds();
+    // 已设置的唤醒时间不晚于最早定时器的容差上限，沿用即可；
+    // 比最早的定时器还早也没关系（最早的定时器被取消或者延期了），醒来后没有到期的定时器会再重设
+    if (armedExpiration_ != MonoTimestamp::invalid() && armedExpiration_.microSeconds() <= expiration + slackUs_)
     {
-        earliestChanged = true;
+        timerfdUpdatesSaved_.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
-
-    std::pair<TimerSet::iterator, bool> result = timers_.insert(std::make_pair(when, timer));
-    assert(result.second);
-
-    return earliestChanged;
+    // 唤醒时间向上对齐到slackUs_的整数倍，同一个对齐区间内到期的定时器共用一次唤醒
+    if (slackUs_ > 0)
+        expiration = (expiration + slackUs_ - 1) / slackUs_ * slackUs_;
+    armedExpiration_ = MonoTimestamp(expiration);
+    updateTimerFd(armedExpiration_);
 }
 
-void TimerQueue::updateTimerFd(Timestamp expiration)
+void TimerQueue::updateTimerFd(MonoTimestamp expiration)
 {
-    int64_t diff = expiration.microSecondsSinceEpoch()
-                 - Timestamp::now().microSecondsSinceEpoch();
-    if (diff < 100) diff = 100; // 最小 100 μs
+    // 定时器和timerfd都使用CLOCK_MONOTONIC，直接设置绝对时间，不需要再读一次当前时间；
+    // 设置的时间已经过去时timerfd立即触发
     struct itimerspec new_value;
     bzero(&new_value, sizeof new_value);
-    new_value.it_value.tv_sec  = diff / Timestamp::kMicroSecondsPerSecond;
-    new_value.it_value.tv_nsec = (diff % Timestamp::kMicroSecondsPerSecond) * 1000;
-    // 取消绝对模式
-    if (::timerfd_settime(timerfd_, /*flags=*/0, &new_value, nullptr) < 0)
+    new_value.it_value = detail::toTimeSpec(expiration);
+    timerfdUpdates_.fetch_add(1, std::memory_order_relaxed);
+    if (::timerfd_settime(timerfd_, TFD_TIMER_ABSTIME, &new_value, nullptr) < 0)
     {
         LOG_ERROR << "timerfd_settime failed";
     }
@@ -183,26 +270,54 @@ void TimerQueue::cancelInLoop(TimerId timerId)
 {
     loop_->assertInLoopThread();
 
-    auto timer = timerId.timer();
+    Timer *timer = lookup(timerId);
     if (!timer) return;
 
-    auto compare = [timer](const Entry& entry) {
-        return entry.second.get() == timer.get();
-    };
+    if (timers_->erase(timer))
+    {
+        LOG_TRACE << "Cancel timer immediately";
+        destroy(timer);
+        return;
+    }
 
-    for (auto it = timers_.begin(); it != timers_.end(); ++it)
-        if (compare(*it))
-        {
-            LOG_TRACE << "Cancel timer immediately";
-            it->second->cancel();
-            timers_.erase(it);
-            return;
-        }
-    
-    if(callingExpiredTimers_)//timer可能在getExpired函数中
+    // 不在容器中：正在执行回调（在expired_中），或者跨线程添加还没有加入，由reset/addTimerInLoop回收
+    if (callingExpiredTimers_)
     {
         LOG_TRACE << "Delay cancel timer (in callback)";
-        cancelingTimers_.insert(timer);
     }
+    timer->cancel();
+}
+
+void TimerQueue::extend(TimerId timerId, MonoTimestamp when)
+{
+    loop_->runInLoop(
+        [this, timerId, when]() { this->extendInLoop(timerId, when); }
+    );
+}
+
+void TimerQueue::extendInLoop(TimerId timerId, MonoTimestamp when)
+{
+    loop_->assertInLoopThread();
 
-}
\ No newline at end of file
+    Timer *timer = lookup(timerId);
+    if (!timer || timer->canceled()) return;
+
+    if (timers_->erase(timer))
+    {
+        timer->setExpiration(when);
+        if (insert(timer))
+        {
+            rearm();
+        }
+        return;
+    }
+
+    // 不在容器中：正在执行回调，回调结束后在reset中按新的到期时间重新加入；
+    // 或者跨线程添加还没有加入，addTimerInLoop直接按新的到期时间加入
+    if (callingExpiredTimers_)
+    {
+        LOG_TRACE << "Delay extend timer (in callback)";
+    }
+    timer->setExpiration(when);
+    timer->setRescheduled(true);
+}
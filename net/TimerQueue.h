@@ -1,48 +1,89 @@
 #pragma once
 #include "noncopyable.h"
-#include "Timestamp.h"
+#include "MonoTimestamp.h"
 #include "Channel.h"
+#include "ObjectPool.h"
 #include "Timer.h"
+#include "TimerContainer.h"
 
+#include <atomic>
 #include <memory>
-#include <set>
-#include <unordered_set>
 
 class TimerId;
 class EventLoop;
 
+/**
+ * 两种驱动方式，由环境变量 TIMER_SOURCE 选择：
+ *   timerfd（默认） 到期时间精确到微秒
+ *   poll           EventLoop每轮按最早的定时器计算poll的超时，poll返回后调用processExpired执行到期的定时器，
+ *                  每次到期省掉timerfd的epoll唤醒、read和timerfd_settime三次系统调用，精度为1ms（超时向上取整，不会提前触发），
+ *                  定时器很多、能接受毫秒级精度时使用
+ */
 class TimerQueue : noncopyable
 {
     public:
         TimerQueue(EventLoop* loop);
         ~TimerQueue();
 
-        TimerId addTimer(const Timer::TimerCallback& cb, Timestamp when, double interval);
+        // 任意线程调用，Timer从本队列的对象池中分配；池按需扩容，存活的定时器再多也不会抛异常（内存耗尽除外）
+        TimerId addTimer(Timer::TimerCallback cb, MonoTimestamp when, double interval);
 
         void cancel(TimerId timerId);
 
+        // 把定时器的下一次到期时间改为when，原地重新排队，不重新分配Timer
+        // 定时器已经触发完（非重复定时器）或者已经取消时什么也不做
+        void extend(TimerId timerId, MonoTimestamp when);
+
+        // 只能在loop线程调用，见EventLoop::setTimerSlack
+        void setSlack(int64_t slackUs);
+
+        // 以下两个只能在loop线程调用，timerfd模式下不做任何事
+        // poll最多等待的毫秒数：到最早的定时器（加上容差）为止，不超过maxMs
+        int pollTimeoutMs(int maxMs) const;
+        // poll返回后调用，执行到期的定时器
+        void processExpired();
+
+        // 统计，任意线程可读
+        uint64_t timerfdUpdates() const { return timerfdUpdates_.load(std::memory_order_relaxed); }
+        uint64_t timerfdUpdatesSaved() const { return timerfdUpdatesSaved_.load(std::memory_order_relaxed); }
+        uint64_t wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+        uint64_t timersFired() const { return timersFired_.load(std::memory_order_relaxed); }
+
     private:
-        using Entry = std::pair<Timestamp, std::shared_ptr<Timer>>;
-        using TimerSet = std::set<Entry>;
+        using TimerList = TimerContainer::TimerList;
 
-        void addTimerInLoop(const std::shared_ptr<Timer>& timer);
+        void addTimerInLoop(Timer* timer);
 
         void handleRead();
+        void runExpired(MonoTimestamp now);
 
-        //move out all expired timers
-        std::vector<Entry> getExpired(Timestamp now);
-        void reset(const std::vector<Entry>& expired, Timestamp now);
+        void reset(const TimerList& expired, MonoTimestamp now);
 
-        bool insert(std::shared_ptr<Timer> timer);
+        bool insert(Timer* timer);
+        // 句柄对应的定时器已经回收时返回nullptr
+        Timer* lookup(TimerId timerId) const;
+        void destroy(Timer* timer) { pool_.destroy(timer); }
 
-        void updateTimerFd(Timestamp expiration);
+        // 最早的定时器提前了（或者timerfd已经触发过）时调用，必要时重设timerfd
+        void rearm();
+        void updateTimerFd(MonoTimestamp expiration);
 
         void cancelInLoop(TimerId timerId);
+        void extendInLoop(TimerId timerId, MonoTimestamp when);
 
         EventLoop* loop_;
-        const int timerfd_;
+        const bool useTimerfd_;
+        const int timerfd_; // poll模式下为-1
         Channel timerfdChannel_;
-        TimerSet timers_;
+        ObjectPool<Timer> pool_; // 必须在timers_之前构造、之后析构
+        std::unique_ptr<TimerContainer> timers_; // 由环境变量 TIMER_BACKEND 选择实现
+        TimerList expired_; // 每轮到期的定时器，复用同一个数组
         bool callingExpiredTimers_; //atomic
-        std::unordered_set<std::shared_ptr<Timer>, Timer::Hash, Timer::Equal> cancelingTimers_;
+        int64_t slackUs_;
+        MonoTimestamp armedExpiration_; // timerfd当前设置的唤醒时间，invalid表示没有设置
+
+        std::atomic<uint64_t> timerfdUpdates_;
+        std::atomic<uint64_t> timerfdUpdatesSaved_;
+        std::atomic<uint64_t> wakeups_;
+        std::atomic<uint64_t> timersFired_;
 };
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "TimerSet.h"
+#include "Timer.h"
+
+#include <cassert>
+
+TimerSet::TimerSet() : nextSequence_(0) {}
+
+bool TimerSet::Before::operator()(const Timer *a, const Timer *b) const
+{
+    if (a->expiration_ != b->expiration_)
+        return a->expiration_ < b->expiration_;
+    return a->sequence_ < b->sequence_;
+}
+
+void TimerSet::insert(Timer *timer)
+{
+    assert(timer->index_ < 0);
+    timer->sequence_ = nextSequence_++;
+    timer->index_ = 0;
+    bool inserted = timers_.insert(timer).second;
+    assert(inserted);
+    (void)inserted;
+}
+
+bool TimerSet::erase(Timer *timer)
+{
+    if (timer->index_ < 0)
+        return false;
+    // 在容器中的定时器到期时间不会改变，直接按(到期时间, 加入顺序)查找
+    size_t n = timers_.erase(timer);
+    assert(n == 1);
+    (void)n;
+    timer->index_ = -1;
+    return true;
+}
+
+void TimerSet::getExpired(MonoTimestamp now, TimerList *expired)
+{
+    auto it = timers_.begin();
+    while (it != timers_.end() && !(now < (*it)->expiration_))
+    {
+        (*it)->index_ = -1;
+        expired->push_back(*it);
+        ++it;
+    }
+    timers_.erase(timers_.begin(), it);
+}
+
+void TimerSet::clear(TimerList *timers)
+{
+    for (Timer *timer : timers_)
+    {
+        timer->index_ = -1;
+        timers->push_back(timer);
+    }
+    timers_.clear();
+}
+
+MonoTimestamp TimerSet::earliest() const
+{
+    return timers_.empty() ? MonoTimestamp::invalid() : (*timers_.begin())->expiration_;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "TimerContainer.h"
+
+#include <set>
+#include <stdint.h>
+
+// 按(到期时间, 加入顺序)排序的有序集合，最早到期的定时器在begin()；每次加入分配一个set节点
+class TimerSet : public TimerContainer
+{
+  public:
+    TimerSet();
+    ~TimerSet() override = default;
+
+    void insert(Timer *timer) override;
+    bool erase(Timer *timer) override;
+    void getExpired(MonoTimestamp now, TimerList *expired) override;
+    void clear(TimerList *timers) override;
+    MonoTimestamp earliest() const override;
+    size_t size() const override { return timers_.size(); }
+
+  private:
+    struct Before
+    {
+        bool operator()(const Timer *a, const Timer *b) const;
+    };
+
+    std::set<Timer *, Before> timers_;
+    uint64_t nextSequence_;
+};
@@ -0,0 +1,228 @@
+#include "TimerWheel.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+
+// 从pos开始（含）循环查找64位位图中第一个置位的位置，返回相对pos的偏移，没有返回-1
+int findNext64(uint64_t bits, int pos)
+{
+    if (bits == 0)
+        return -1;
+    uint64_t rotated = pos == 0 ? bits : (bits >> pos) | (bits << (64 - pos));
+    return __builtin_ctzll(rotated);
+}
+
+} // namespace
+
+TimerWheel::TimerWheel()
+    : current_(MonoTimestamp::now().microSeconds() / kTickUs), size_(0)
+{
+    for (int i = 0; i < kNumSlots; ++i)
+        slots_[i] = nullptr;
+    for (uint64_t &bits : level0Bits_)
+        bits = 0;
+    for (uint64_t &bits : upperBits_)
+        bits = 0;
+}
+
+TimerWheel::~TimerWheel() = default;
+
+int64_t TimerWheel::tickOf(const Timer *timer)
+{
+    return (timer->expiration().microSeconds() + kTickUs - 1) / kTickUs;
+}
+
+void TimerWheel::insert(Timer *timer)
+{
+    assert(timer->index_ < 0);
+    place(timer);
+    ++size_;
+}
+
+bool TimerWheel::erase(Timer *timer)
+{
+    if (timer->index_ < 0)
+        return false;
+    unlink(timer);
+    --size_;
+    return true;
+}
+
+void TimerWheel::clear(TimerList *timers)
+{
+    for (int i = 0; i < kNumSlots; ++i)
+    {
+        while (Timer *timer = slots_[i])
+        {
+            unlink(timer);
+            timers->push_back(timer);
+        }
+    }
+    size_ = 0;
+}
+
+void TimerWheel::place(Timer *timer)
+{
+    int64_t tick = tickOf(timer);
+    int64_t delta = tick - current_;
+    int slot;
+    if (delta < 0)
+    {
+        // 已经过期，放到下一个要处理的槽
+        slot = slotIndex(0, static_cast<int>(current_ & (kLevel0Size - 1)));
+    }
+    else if (delta < kLevel0Size)
+    {
+        slot = slotIndex(0, static_cast<int>(tick & (kLevel0Size - 1)));
+    }
+    else
+    {
+        int level = 1;
+        while (level < kUpperLevels && delta >= (int64_t(1) << levelShift(level + 1)))
+            ++level;
+        if (level == kUpperLevels && delta >= (int64_t(1) << (levelShift(level) + kLevelBits)))
+        {
+            // 超出时间轮的范围，先放在最远的位置，cascade时按真实的到期时间重新分配
+            tick = current_ + (int64_t(1) << (levelShift(level) + kLevelBits)) - 1;
+        }
+        slot = slotIndex(level, static_cast<int>((tick >> levelShift(level)) & (kLevelSize - 1)));
+    }
+    link(timer, slot);
+}
+
+void TimerWheel::link(Timer *timer, int slot)
+{
+    Timer *head = slots_[slot];
+    timer->prev_ = nullptr;
+    timer->next_ = head;
+    if (head != nullptr)
+        head->prev_ = timer;
+    slots_[slot] = timer;
+    timer->index_ = slot;
+    if (slot < kLevel0Size)
+        level0Bits_[slot >> 6] |= uint64_t(1) << (slot & 63);
+    else
+        upperBits_[(slot - kLevel0Size) / kLevelSize] |= uint64_t(1) << ((slot - kLevel0Size) % kLevelSize);
+}
+
+void TimerWheel::unlink(Timer *timer)
+{
+    int slot = timer->index_;
+    if (timer->prev_ != nullptr)
+        timer->prev_->next_ = timer->next_;
+    else
+        slots_[slot] = timer->next_;
+    if (timer->next_ != nullptr)
+        timer->next_->prev_ = timer->prev_;
+    timer->prev_ = nullptr;
+    timer->next_ = nullptr;
+    timer->index_ = -1;
+    if (slots_[slot] == nullptr)
+    {
+        if (slot < kLevel0Size)
+            level0Bits_[slot >> 6] &= ~(uint64_t(1) << (slot & 63));
+        else
+            upperBits_[(slot - kLevel0Size) / kLevelSize] &= ~(uint64_t(1) << ((slot - kLevel0Size) % kLevelSize));
+    }
+}
+
+int TimerWheel::cascade(int level, int index)
+{
+    // 先记下next再重新分配，放回同一个槽（挂在链表头）的定时器不会被再次处理
+    Timer *timer = slots_[slotIndex(level, index)];
+    while (timer != nullptr)
+    {
+        Timer *next = timer->next_;
+        unlink(timer);
+        place(timer);
+        timer = next;
+    }
+    return index;
+}
+
+int TimerWheel::findLevel0(int pos) const
+{
+    const int words = kLevel0Size / 64;
+    for (int n = 0; n <= words; ++n)
+    {
+        int w = ((pos >> 6) + n) % words;
+        uint64_t bits = level0Bits_[w];
+        if (n == 0)
+            bits &= ~uint64_t(0) << (pos & 63);
+        else if (n == words)
+            bits &= (pos & 63) == 0 ? 0 : ~(~uint64_t(0) << (pos & 63)); // 绕回起始字中pos之前的部分
+        if (bits != 0)
+            return (w * 64 + __builtin_ctzll(bits) - pos) & (kLevel0Size - 1);
+    }
+    return -1;
+}
+
+void TimerWheel::getExpired(MonoTimestamp now, TimerList *expired)
+{
+    int64_t target = now.microSeconds() / kTickUs;
+    for (;;)
+    {
+        // 中间没有定时器也没有需要cascade的槽，直接跳过，空闲很久之后也不用逐个tick推进
+        int64_t next = nextTick();
+        if (next < 0 || next > target)
+        {
+            current_ = std::max(current_, target + 1);
+            return;
+        }
+        current_ = next;
+
+        int index = static_cast<int>(current_ & (kLevel0Size - 1));
+        if (index == 0)
+        {
+            int level = 1;
+            while (level <= kUpperLevels &&
+                   cascade(level, static_cast<int>((current_ >> levelShift(level)) & (kLevelSize - 1))) == 0)
+                ++level;
+        }
+        while (Timer *timer = slots_[index])
+        {
+            unlink(timer);
+            expired->push_back(timer);
+            --size_;
+        }
+        ++current_;
+    }
+}
+
+MonoTimestamp TimerWheel::earliest() const
+{
+    int64_t next = nextTick();
+    return next < 0 ? MonoTimestamp::invalid() : MonoTimestamp(next * kTickUs);
+}
+
+int64_t TimerWheel::nextTick() const
+{
+    if (size_ == 0)
+        return -1;
+
+    int64_t next = -1;
+    int offset = findLevel0(static_cast<int>(current_ & (kLevel0Size - 1)));
+    if (offset >= 0)
+        next = current_ + offset;
+
+    // 上层的定时器在所在的槽cascade时才会落到第0层，需要在那个时刻处理
+    for (int level = 1; level <= kUpperLevels; ++level)
+    {
+        uint64_t bits = upperBits_[level - 1];
+        if (bits == 0)
+            continue;
+        int shift = levelShift(level);
+        int64_t mask = (int64_t(1) << shift) - 1;
+        int64_t boundary = (current_ + mask) & ~mask;
+        int pos = static_cast<int>((boundary >> shift) & (kLevelSize - 1));
+        int64_t tick = boundary + (static_cast<int64_t>(findNext64(bits, pos)) << shift);
+        if (next < 0 || tick < next)
+            next = tick;
+    }
+    assert(next >= 0);
+    return next;
+}
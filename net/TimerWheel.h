@@ -0,0 +1,61 @@
+#pragma once
+#include "TimerContainer.h"
+
+#include <stdint.h>
+
+/**
+ * 分层时间轮（和早期Linux内核的timer wheel相同的结构）
+ * 时间按kTickUs切分成tick，定时器的到期时间向上取整到tick，保证不会提前触发，最多晚一个tick。
+ *   第0层 256个槽，每槽1个tick，覆盖256ms
+ *   第1~4层 各64个槽，每槽分别是 2^8、2^14、2^20、2^26 个tick，最远约49天，更远的先放在最后一层
+ * 每个槽是挂在Timer上的侵入式双向链表，插入和取消都是O(1)且不分配内存；
+ * 第0层转完一圈时把上一层对应槽里的定时器重新分配到下层（cascade）。
+ * 同一个tick内到期的定时器之间不保证先后顺序。
+ */
+class TimerWheel : public TimerContainer
+{
+  public:
+    TimerWheel();
+    ~TimerWheel() override;
+
+    void insert(Timer *timer) override;
+    bool erase(Timer *timer) override;
+    void getExpired(MonoTimestamp now, TimerList *expired) override;
+    void clear(TimerList *timers) override;
+    MonoTimestamp earliest() const override;
+    size_t size() const override { return size_; }
+
+    static const int64_t kTickUs = 1000;
+
+  private:
+    static const int kLevel0Bits = 8;
+    static const int kLevelBits = 6;
+    static const int kLevel0Size = 1 << kLevel0Bits;
+    static const int kLevelSize = 1 << kLevelBits;
+    static const int kUpperLevels = 4;
+    static const int kNumSlots = kLevel0Size + kUpperLevels * kLevelSize;
+
+    static int64_t tickOf(const Timer *timer);
+    static int levelShift(int level) { return kLevel0Bits + (level - 1) * kLevelBits; }
+    static int slotIndex(int level, int index)
+    {
+        return level == 0 ? index : kLevel0Size + (level - 1) * kLevelSize + index;
+    }
+
+    // 按当前的current_把定时器挂到对应的层和槽
+    void place(Timer *timer);
+    void link(Timer *timer, int slot);
+    void unlink(Timer *timer);
+    // 把第level层的第index个槽重新分配到下层，返回index
+    int cascade(int level, int index);
+    // 下一个需要处理的tick（有定时器到期或者有非空的槽需要cascade），为空时返回-1
+    int64_t nextTick() const;
+    // 从第0层的第pos个槽开始（含）循环查找第一个非空槽，返回相对pos的偏移，没有返回-1
+    int findLevel0(int pos) const;
+
+    Timer *slots_[kNumSlots];
+    uint64_t level0Bits_[kLevel0Size / 64]; // 第0层非空槽的位图
+    uint64_t upperBits_[kUpperLevels];      // 第1~4层非空槽的位图
+    int64_t current_; // 下一个要处理的tick，之前的tick都已经处理过
+    size_t size_;
+};
@@ -0,0 +1,81 @@
+#include "TcpServer.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "Callbacks.h"
+#include "TcpConnection.h"
+#include "Buffer.h"
+#include <stdio.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char* g_file = nullptr;
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    printf("onConnection(): tid=%d new connection [%s] from %s\n",
+           CurrentThread::tid(),
+           conn->name().c_str(),
+           conn->peerAddress().toIpPort().c_str());
+    int fd = ::open(g_file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+      perror("open");
+      conn->shutdown();
+      return;
+    }
+    struct stat st;
+    ::fstat(fd, &st);
+    // 文件内容夹在两段普通数据之间，验证发送顺序
+    conn->send("----- begin -----\n");
+    conn->sendFile(fd, 0, static_cast<size_t>(st.st_size));
+    ::close(fd); // sendFile内部持有dup出来的fd
+    conn->send("----- end -----\n");
+    conn->shutdown();
+  }
+  else
+  {
+    printf("onConnection(): tid=%d connection [%s] is down\n",
+           CurrentThread::tid(),
+           conn->name().c_str());
+  }
+}
+
+void onWriteComplete(const TcpConnectionPtr& conn)
+{
+  printf("onWriteComplete(): connection [%s]\n", conn->name().c_str());
+}
+
+void onMessage(const TcpConnectionPtr& conn,
+               Buffer* buf,
+               Timestamp receiveTime)
+{
+  buf->retrieveAll();
+}
+
+int main(int argc, char* argv[])
+{
+  printf("main(): pid = %d\n", getpid());
+  if (argc < 2)
+  {
+    printf("Usage: %s file [threads]\n", argv[0]);
+    return 0;
+  }
+  g_file = argv[1];
+
+  InetAddress listenAddr(9981);
+  EventLoop loop;
+
+  TcpServer server(&loop, listenAddr);
+  server.setConnectionCallback(onConnection);
+  server.setMessageCallback(onMessage);
+  server.setWriteCompleteCallback(onWriteComplete);
+  if (argc > 2) {
+    server.setThreadNum(atoi(argv[2]));
+  }
+  server.start();
+
+  loop.loop();
+}
@@ -0,0 +1,70 @@
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "Callbacks.h"
+#include "TcpConnection.h"
+#include "Buffer.h"
+#include <stdio.h>
+#include <map>
+#include <memory>
+
+// 用splice实现的TCP中继：9982 -> 127.0.0.1:9981
+EventLoop* g_loop;
+InetAddress* g_backendAddr;
+std::map<std::string, std::unique_ptr<TcpClient>> g_clients;
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    printf("onServerConnection(): new connection [%s] from %s\n",
+           conn->name().c_str(),
+           conn->peerAddress().toIpPort().c_str());
+    std::unique_ptr<TcpClient> client(new TcpClient(g_loop, *g_backendAddr, conn->name()));
+    std::weak_ptr<TcpConnection> weakConn(conn);
+    client->setConnectionCallback([weakConn](const TcpConnectionPtr& backend) {
+      TcpConnectionPtr front = weakConn.lock();
+      if (backend->connected() && front)
+      {
+        // 两个方向各建立一条splice通道
+        front->startSplice(backend);
+        backend->startSplice(front);
+      }
+    });
+    client->setMessageCallback([](const TcpConnectionPtr&, Buffer*, Timestamp) {});
+    client->connect();
+    g_clients[conn->name()] = std::move(client);
+  }
+  else
+  {
+    printf("onServerConnection(): connection [%s] is down\n",
+           conn->name().c_str());
+    g_clients.erase(conn->name());
+  }
+}
+
+void onServerMessage(const TcpConnectionPtr& conn,
+                     Buffer* buf,
+                     Timestamp receiveTime)
+{
+  // 后端还没连上，数据先留在inputBuffer_里，startSplice时一并转发
+}
+
+int main(int argc, char* argv[])
+{
+  printf("main(): pid = %d\n", getpid());
+
+  EventLoop loop;
+  g_loop = &loop;
+  InetAddress backendAddr(9981, "127.0.0.1");
+  g_backendAddr = &backendAddr;
+
+  InetAddress listenAddr(9982);
+  TcpServer server(&loop, listenAddr);
+  server.setConnectionCallback(onServerConnection);
+  server.setMessageCallback(onServerMessage);
+  server.start();
+
+  loop.loop();
+}
@@ -0,0 +1,52 @@
+#include "TcpServer.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "Callbacks.h"
+#include "TcpConnection.h"
+#include "Buffer.h"
+#include <stdio.h>
+
+// io_uring完成式I/O的echo服务器，运行前设置 POLLER_BACKEND=io_uring
+void onConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    printf("onConnection(): tid=%d new connection [%s] from %s, io_uring=%d\n",
+           CurrentThread::tid(),
+           conn->name().c_str(),
+           conn->peerAddress().toIpPort().c_str(),
+           conn->ioUringMode());
+  }
+  else
+  {
+    printf("onConnection(): tid=%d connection [%s] is down\n",
+           CurrentThread::tid(),
+           conn->name().c_str());
+  }
+}
+
+void onMessage(const TcpConnectionPtr& conn,
+               Buffer* buf,
+               Timestamp receiveTime)
+{
+  conn->send(buf->retrieveAllAsString());
+}
+
+int main(int argc, char* argv[])
+{
+  printf("main(): pid = %d\n", getpid());
+
+  InetAddress listenAddr(9981);
+  EventLoop loop;
+
+  TcpServer server(&loop, listenAddr);
+  server.setConnectionCallback(onConnection);
+  server.setMessageCallback(onMessage);
+  server.setIoUringMode(true);
+  if (argc > 1) {
+    server.setThreadNum(atoi(argv[1]));
+  }
+  server.start();
+
+  loop.loop();
+}
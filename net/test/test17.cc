@@ -0,0 +1,56 @@
+#include "TcpServer.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "Callbacks.h"
+#include "TcpConnection.h"
+#include "Buffer.h"
+#include <stdio.h>
+
+// 忙轮询模式的echo服务器：./test17 [最大自旋微秒数] [线程数]，每2秒打印一次loop统计
+EventLoop* g_loop;
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    conn->setTcpNoDelay(true);
+  }
+}
+
+void onMessage(const TcpConnectionPtr& conn,
+               Buffer* buf,
+               Timestamp receiveTime)
+{
+  conn->send(buf->retrieveAllAsString());
+}
+
+void printStats()
+{
+  EventLoop::Stats s = g_loop->stats();
+  printf("busyPollHits=%lu busyPollMisses=%lu spinBudgetUs=%ld wakeupWrites=%lu wakeupsSaved=%lu\n",
+         (unsigned long)s.busyPollHits, (unsigned long)s.busyPollMisses, (long)s.spinBudgetUs,
+         (unsigned long)s.wakeupWrites, (unsigned long)s.wakeupsSaved);
+  fflush(stdout);
+}
+
+int main(int argc, char* argv[])
+{
+  printf("main(): pid = %d\n", getpid());
+
+  int64_t spinUs = argc > 1 ? atoi(argv[1]) : 200;
+  InetAddress listenAddr(9981);
+  EventLoop loop;
+  g_loop = &loop;
+
+  TcpServer server(&loop, listenAddr);
+  server.setConnectionCallback(onConnection);
+  server.setMessageCallback(onMessage);
+  server.setBusyPoll(spinUs);
+  if (argc > 2) {
+    server.setThreadNum(atoi(argv[2]));
+  }
+  server.start();
+  loop.runEvery(2.0, printStats);
+
+  loop.loop();
+}
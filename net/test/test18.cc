@@ -0,0 +1,83 @@
+#include "EventLoop.h"
+#include "TimerId.h"
+#include "Timestamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// 模拟每个连接一个空闲超时：./test18 [定时器个数] [定时器容差微秒数]
+// 先添加N个30~60秒后到期的定时器，再分别用取消后重新添加、extendAfter两种方式各刷新一次超时，
+// 最后添加一批间隔37微秒的短定时器，验证按时触发，并打印timerfd重设/唤醒次数
+// 用环境变量 TIMER_BACKEND=heap|set|wheel 对比三种容器，TIMER_SOURCE=poll|timerfd 对比两种驱动方式
+EventLoop* g_loop;
+const int kShortTimers = 10000;
+int g_fired = 0;
+int64_t g_maxLateUs = 0;
+
+double elapsed(Timestamp start)
+{
+  return static_cast<double>(Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch()) / 1000;
+}
+
+int main(int argc, char* argv[])
+{
+  int n = argc > 1 ? atoi(argv[1]) : 100000;
+  int64_t slackUs = argc > 2 ? atoi(argv[2]) : 0;
+  const char* backend = getenv("TIMER_BACKEND");
+  const char* source = getenv("TIMER_SOURCE");
+  printf("backend = %s, source = %s, timers = %d, slack = %ld us\n", backend ? backend : "heap",
+         source ? source : "timerfd", n, static_cast<long>(slackUs));
+
+  EventLoop loop;
+  g_loop = &loop;
+  loop.setTimerSlack(slackUs);
+  std::vector<TimerId> ids(n);
+
+  Timestamp start = Timestamp::now();
+  for (int i = 0; i < n; ++i)
+    ids[i] = loop.runAfter(30 + (i % 30000) / 1000.0, [] { printf("idle timeout should not fire\n"); });
+  printf("add     %8.1f ms\n", elapsed(start));
+
+  start = Timestamp::now();
+  for (int i = 0; i < n; ++i)
+  {
+    loop.cancel(ids[i]);
+    ids[i] = loop.runAfter(30 + (i % 30000) / 1000.0, [] { printf("idle timeout should not fire\n"); });
+  }
+  printf("refresh %8.1f ms (cancel + runAfter)\n", elapsed(start));
+
+  start = Timestamp::now();
+  for (int i = 0; i < n; ++i)
+    loop.extendAfter(ids[i], 30 + (i % 30000) / 1000.0);
+  printf("extend  %8.1f ms\n", elapsed(start));
+
+  EventLoop::Stats before = loop.stats();
+  Timestamp base = addTime(Timestamp::now(), 0.01);
+  // 倒序添加，每个新定时器都比之前的早
+  for (int i = kShortTimers - 1; i >= 0; --i)
+  {
+    Timestamp when(base.microSecondsSinceEpoch() + i * 37);
+    loop.runAt(when, [when] {
+      int64_t late = Timestamp::now().microSecondsSinceEpoch() - when.microSecondsSinceEpoch();
+      if (late > g_maxLateUs)
+        g_maxLateUs = late;
+      ++g_fired;
+    });
+  }
+  loop.runAfter(1.5, [&] {
+    EventLoop::Stats s = g_loop->stats();
+    printf("short timers fired %d/%d, max late %ld us\n", g_fired, kShortTimers, static_cast<long>(g_maxLateUs));
+    printf("timerfdUpdates=%lu timerfdUpdatesSaved=%lu timerWakeups=%lu timersFired=%lu\n",
+           (unsigned long)(s.timerfdUpdates - before.timerfdUpdates),
+           (unsigned long)(s.timerfdUpdatesSaved - before.timerfdUpdatesSaved),
+           (unsigned long)(s.timerWakeups - before.timerWakeups),
+           (unsigned long)(s.timersFired - before.timersFired));
+    start = Timestamp::now();
+    for (int i = 0; i < n; ++i)
+      g_loop->cancel(ids[i]);
+    printf("cancel  %8.1f ms\n", elapsed(start));
+    g_loop->quit();
+  });
+  loop.loop();
+}
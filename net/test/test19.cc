@@ -0,0 +1,49 @@
+#include "AsyncLogging.h"
+#include "Logger.h"
+#include "Timestamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+// 多线程写AsyncLogging的吞吐：./test19 [线程数] [每个线程的日志条数]
+// 日志写到 /tmp/test19.*.log，可以用 wc -l 核对条数，每个线程的日志在文件中保持先后顺序
+AsyncLogging* g_asyncLog = nullptr;
+
+void asyncOutput(const char* msg, int len)
+{
+  g_asyncLog->append(msg, len);
+}
+
+int main(int argc, char* argv[])
+{
+  int threads = argc > 1 ? atoi(argv[1]) : 4;
+  int lines = argc > 2 ? atoi(argv[2]) : 1000000;
+
+  AsyncLogging log("/tmp/test19", 500 * 1000 * 1000);
+  // 不限制缓冲，后端跟不上时也不丢日志，才能核对条数（丢弃策略见test24）
+  log.setBufferLimit(0);
+  log.setTotalBufferLimit(0);
+  g_asyncLog = &log;
+  Logger::setOutput(asyncOutput);
+  log.start();
+
+  Timestamp start = Timestamp::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t)
+  {
+    workers.emplace_back([t, lines] {
+      for (int i = 0; i < lines; ++i)
+        LOG_INFO << "thread " << t << " line " << i << " abcdefghijklmnopqrstuvwxyz";
+    });
+  }
+  for (std::thread& worker : workers)
+    worker.join();
+  double seconds = static_cast<double>(Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch()) /
+                   Timestamp::kMicroSecondsPerSecond;
+  long total = static_cast<long>(threads) * lines;
+  printf("%d threads, %ld lines, %.3f s, %.1f ns/line, %.0f lines/s\n", threads, total, seconds,
+         seconds * 1e9 / static_cast<double>(total), static_cast<double>(total) / seconds);
+  log.stop();
+}
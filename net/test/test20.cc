@@ -0,0 +1,53 @@
+#include "AsyncLogging.h"
+#include "BinaryLog.h"
+#include "Logger.h"
+#include "Timestamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+// 文本日志和二进制日志的前端开销对比：./test20 [条数]
+// 文本日志写到 /tmp/test20.text.*.log，二进制日志写到 /tmp/test20.bin.*.log，
+// 用 logdecoder /tmp/test20.bin.*.log 还原后和文本日志的内容一致（时间戳除外）；
+// 可以加第二个参数指定滚动大小（字节），每个滚动出的二进制文件都可以单独用logdecoder解码
+AsyncLogging* g_textLog = nullptr;
+AsyncLogging* g_binaryLog = nullptr;
+
+double elapsedNs(Timestamp start, int n)
+{
+  return static_cast<double>(Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch()) * 1000 / n;
+}
+
+int main(int argc, char* argv[])
+{
+  int n = argc > 1 ? atoi(argv[1]) : 1000000;
+  off_t rollSize = argc > 2 ? atol(argv[2]) : 500 * 1000 * 1000;
+  std::string peer = "192.168.1.100:54321";
+
+  AsyncLogging textLog("/tmp/test20.text", rollSize);
+  AsyncLogging binaryLog("/tmp/test20.bin", rollSize);
+  g_textLog = &textLog;
+  g_binaryLog = &binaryLog;
+  // 每个二进制日志文件开头都写一遍调用点定义，滚动出的文件可以单独解码
+  binaryLog.setFileHeader(BinaryLog::siteTable);
+  // 丢弃日志的说明也写成二进制记录，不能是一行文本
+  binaryLog.setDropMarker(BinaryLog::dropMarker);
+  textLog.start();
+  binaryLog.start();
+  Logger::setOutput([](const char* msg, int len) { g_textLog->append(msg, len); });
+  BinaryLog::setOutput([](const char* msg, int len) { g_binaryLog->append(msg, len); });
+
+  Timestamp start = Timestamp::now();
+  for (int i = 0; i < n; ++i)
+    LOG_INFO << "connection " << i << " from " << peer << " closed after " << i * 0.5 << " s";
+  printf("text   %6.1f ns/line\n", elapsedNs(start, n));
+
+  start = Timestamp::now();
+  for (int i = 0; i < n; ++i)
+    LOG_BIN_INFO("connection {} from {} closed after {} s", i, peer, i * 0.5);
+  printf("binary %6.1f ns/line\n", elapsedNs(start, n));
+
+  textLog.stop();
+  binaryLog.stop();
+}
@@ -0,0 +1,65 @@
+#include "Channel.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "Timestamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// epoll路径上LOG_TRACE的开销：./test21 [事件数]
+// 每个事件：写eventfd -> epoll_wait返回 -> 读eventfd -> 关闭再打开读事件（两次updateChannel/epoll_ctl）
+// 分别在运行时打开TRACE（输出丢弃）和运行时过滤（INFO）下计时；
+// 再用 cmake -DLOG_MIN_LEVEL=INFO 重新编译运行，对比LOG_TRACE在编译期删除后的每事件耗时
+EventLoop* g_loop;
+int g_efd;
+int g_events;
+int g_total;
+
+void onRead(Channel* channel)
+{
+  uint64_t one;
+  ::read(g_efd, &one, sizeof one);
+  channel->disableReading();
+  channel->enableReading();
+  if (++g_events == g_total)
+  {
+    g_loop->quit();
+    return;
+  }
+  one = 1;
+  ::write(g_efd, &one, sizeof one);
+}
+
+double run(Logger::LogLevel level)
+{
+  Logger::setLogLevel(level);
+  g_events = 0;
+  EventLoop loop;
+  g_loop = &loop;
+  g_efd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  Channel channel(&loop, g_efd);
+  channel.setReadCallback([&channel](Timestamp) { onRead(&channel); });
+  channel.enableReading();
+
+  uint64_t one = 1;
+  ::write(g_efd, &one, sizeof one);
+  Timestamp start = Timestamp::now();
+  loop.loop();
+  double ns = static_cast<double>(Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch()) * 1000 /
+              g_total;
+  channel.disableAll();
+  loop.removeChannel(&channel);
+  ::close(g_efd);
+  return ns;
+}
+
+int main(int argc, char* argv[])
+{
+  g_total = argc > 1 ? atoi(argv[1]) : 200000;
+  Logger::setOutput([](const char*, int) {});
+  printf("LOG_MIN_LEVEL = %d, %d events\n", LOG_MIN_LEVEL, g_total);
+  printf("runtime TRACE: %7.1f ns/event\n", run(Logger::TRACE));
+  printf("runtime INFO : %7.1f ns/event\n", run(Logger::INFO));
+}
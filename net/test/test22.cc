@@ -0,0 +1,158 @@
+#include "LogStream.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <inttypes.h>
+#include <limits>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// LogStream数值格式化的微基准：./test22 [次数]
+// 对比原来的实现（逐位除10再反转、snprintf("%.12g")）和现在的实现（两位查表、std::to_chars），
+// 先用snprintf/strtod核对新实现的输出
+namespace old
+{
+const char digits[] = "9876543210123456789";
+const char* zero = digits + 9;
+
+template <typename T>
+int formatInteger(char* buf, T num)
+{
+  char* cur = buf;
+  bool negative = (num < 0);
+  do
+  {
+    int remainder = static_cast<int>(num % 10);
+    *cur++ = zero[remainder];
+    num /= 10;
+  } while (num != 0);
+  if (negative)
+    *cur++ = '-';
+  *cur = '\0';
+  std::reverse(buf, cur);
+  return static_cast<int>(cur - buf);
+}
+
+int formatDouble(char* buf, double num)
+{
+  char tmp[32];
+  snprintf(tmp, sizeof tmp, "%.12g", num);
+  size_t len = strlen(tmp);
+  memcpy(buf, tmp, len);
+  return static_cast<int>(len);
+}
+
+int formatPointer(char* buf, const void* p)
+{
+  return snprintf(buf, 32, "%p", p);
+}
+} // namespace old
+
+int g_errors = 0;
+
+template <typename T>
+void expect(const T& value, const char* want)
+{
+  LogStream stream;
+  stream << value;
+  std::string got = stream.buffer().toString();
+  if (got != want)
+  {
+    printf("MISMATCH got '%s' want '%s'\n", got.c_str(), want);
+    ++g_errors;
+  }
+}
+
+void check(int n)
+{
+  char want[64];
+  expect(0, "0");
+  expect(std::numeric_limits<int>::min(), "-2147483648");
+  expect(std::numeric_limits<int64_t>::min(), "-9223372036854775808");
+  expect(std::numeric_limits<uint64_t>::max(), "18446744073709551615");
+  expect(Hex(0), "0");
+  expect(Hex(0xdeadbeef, 12), "0000deadbeef");
+  expect(Padded(42, 5), "   42");
+  expect(Padded(-42, 5, '0'), "-0042");
+  expect(Padded(123456, 3), "123456");
+  expect(static_cast<const void*>(nullptr), "0x0");
+  expect(0.1, "0.1");
+  expect(0.1f, "0.1");
+  uint64_t x = 88172645463325252ULL;
+  for (int i = 0; i < n; ++i)
+  {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    int64_t v = static_cast<int64_t>(x) >> (x % 64);
+    snprintf(want, sizeof want, "%" PRId64, v);
+    expect(v, want);
+    snprintf(want, sizeof want, "%" PRIx64, x >> (x % 64));
+    expect(Hex(x >> (x % 64)), want);
+
+    double d;
+    memcpy(&d, &x, sizeof d);
+    if (d != d || d - d != 0)
+      continue; // NaN/inf
+    LogStream stream;
+    stream << d;
+    std::string s = stream.buffer().toString();
+    if (strtod(s.c_str(), nullptr) != d)
+    {
+      printf("ROUNDTRIP %.17g -> %s\n", d, s.c_str());
+      ++g_errors;
+    }
+  }
+}
+
+template <typename F>
+void bench(const char* name, int n, F&& f)
+{
+  Timestamp start = Timestamp::now();
+  size_t total = 0;
+  for (int i = 0; i < n; ++i)
+    total += f(i);
+  double ns = static_cast<double>(Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch()) * 1000 / n;
+  printf("%-24s %6.1f ns  (%zu bytes)\n", name, ns, total);
+}
+
+int main(int argc, char* argv[])
+{
+  int n = argc > 1 ? atoi(argv[1]) : 5000000;
+  check(1000000);
+  printf("correctness: %d errors\n", g_errors);
+
+  std::vector<int64_t> ints(1024);
+  std::vector<double> doubles(1024);
+  for (size_t i = 0; i < ints.size(); ++i)
+  {
+    ints[i] = static_cast<int64_t>(rand()) * rand() * (i % 2 ? 1 : -1) >> (i % 40);
+    doubles[i] = static_cast<double>(rand()) / (i + 1) * (i % 3 ? 1e-3 : 1e5);
+  }
+
+  char buf[64];
+  LogStream stream;
+  // 返回本次写入的字节数，缓冲区快满时清空
+  auto emit = [&stream](auto value) {
+    int before = stream.buffer().length();
+    stream << value;
+    int len = stream.buffer().length() - before;
+    if (stream.buffer().avail() < 256)
+      stream.reset_buffer();
+    return len;
+  };
+
+  bench("int old", n, [&](int i) { return old::formatInteger(buf, static_cast<int>(ints[i & 1023])); });
+  bench("int new", n, [&](int i) { return emit(static_cast<int>(ints[i & 1023])); });
+  bench("int64 old", n, [&](int i) { return old::formatInteger(buf, ints[i & 1023]); });
+  bench("int64 new", n, [&](int i) { return emit(static_cast<long>(ints[i & 1023])); });
+  bench("double old (%.12g)", n, [&](int i) { return old::formatDouble(buf, doubles[i & 1023]); });
+  bench("double new (to_chars)", n, [&](int i) { return emit(doubles[i & 1023]); });
+  bench("pointer old (%p)", n, [&](int i) { return old::formatPointer(buf, &ints[i & 1023]); });
+  bench("pointer new", n, [&](int i) { return emit(static_cast<const void*>(&ints[i & 1023])); });
+  bench("padded (%8ld)", n, [&](int i) { return snprintf(buf, sizeof buf, "%8ld", static_cast<long>(ints[i & 1023] % 100000)); });
+  bench("padded new", n, [&](int i) { return emit(Padded(ints[i & 1023] % 100000, 8)); });
+  return g_errors == 0 ? 0 : 1;
+}
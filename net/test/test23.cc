@@ -0,0 +1,52 @@
+#include "LogLimiter.h"
+#include "Logger.h"
+#include "Timestamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// 按调用点限流/采样的日志：./test23 [秒数]
+// 连续若干秒不停地写同一条错误日志，限流为每秒5条、采样为每1000条1条，打印实际输出的行数和快路径耗时
+int g_lines = 0;
+int g_summaries = 0;
+
+void countOutput(const char* msg, int len)
+{
+  ++g_lines;
+  if (strstr(msg, "suppressed ") != nullptr)
+  {
+    ++g_summaries;
+    fwrite(msg, 1, len, stdout);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  double seconds = argc > 1 ? atof(argv[1]) : 2.5;
+  Logger::setOutput(countOutput);
+
+  Timestamp start = Timestamp::now();
+  int64_t deadline = start.microSecondsSinceEpoch() + static_cast<int64_t>(seconds * 1000000);
+  long calls = 0;
+  while (Timestamp::now().microSecondsSinceEpoch() < deadline)
+  {
+    for (int i = 0; i < 1000; ++i)
+      LOG_ERROR_RATELIMIT(5) << "accept Err errno=" << 24;
+    calls += 1000;
+  }
+  printf("rate limit 5/s: %ld calls in %.1f s -> %d lines (%d summaries)\n", calls, seconds, g_lines, g_summaries);
+
+  g_lines = 0;
+  const int kCalls = 10000000;
+  start = Timestamp::now();
+  for (int i = 0; i < kCalls; ++i)
+    LOG_DEBUG_SAMPLED(1000) << "should be filtered by level";
+  double filteredNs = static_cast<double>(Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch()) * 1000 / kCalls;
+  Logger::setLogLevel(Logger::DEBUG);
+  start = Timestamp::now();
+  for (int i = 0; i < kCalls; ++i)
+    LOG_DEBUG_SAMPLED(1000) << "sampled " << i;
+  double sampledNs = static_cast<double>(Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch()) * 1000 / kCalls;
+  printf("sampled 1/1000: %d calls -> %d lines, %.1f ns/call (%.1f ns/call below log level)\n", kCalls, g_lines,
+         sampledNs, filteredNs);
+}
@@ -0,0 +1,69 @@
+#include "AsyncLogging.h"
+#include "Logger.h"
+#include "Timestamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+// AsyncLogging缓冲链满时的处理策略：
+// ./test24 [block|newest|oldest] [每个线程的缓冲上限MB] [线程数] [每个线程的日志条数] [所有线程的缓冲上限MB]
+// 上限设得很小时后端来不及写，打印丢弃的条数、分配块的次数和写文件的耗时，
+// 日志写到 /tmp/test24.*.log，丢弃过日志的地方有一行"dropped N messages"
+AsyncLogging* g_asyncLog = nullptr;
+
+void asyncOutput(const char* msg, int len)
+{
+  g_asyncLog->append(msg, len);
+}
+
+int main(int argc, char* argv[])
+{
+  const char* policyName = argc > 1 ? argv[1] : "oldest";
+  size_t limitMb = argc > 2 ? static_cast<size_t>(atoi(argv[2])) : 2;
+  int threads = argc > 3 ? atoi(argv[3]) : 4;
+  int lines = argc > 4 ? atoi(argv[4]) : 1000000;
+  size_t totalLimitMb = argc > 5 ? static_cast<size_t>(atoi(argv[5])) : 256;
+
+  AsyncLogging::OverflowPolicy policy = AsyncLogging::kDropOldest;
+  if (strcmp(policyName, "block") == 0)
+    policy = AsyncLogging::kBlockProducer;
+  else if (strcmp(policyName, "newest") == 0)
+    policy = AsyncLogging::kDropNewest;
+
+  AsyncLogging log("/tmp/test24", 500 * 1000 * 1000);
+  log.setBufferLimit(limitMb * 1024 * 1024, policy);
+  log.setTotalBufferLimit(totalLimitMb * 1024 * 1024);
+  g_asyncLog = &log;
+  Logger::setOutput(asyncOutput);
+  log.start();
+
+  Timestamp start = Timestamp::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t)
+  {
+    workers.emplace_back([t, lines] {
+      for (int i = 0; i < lines; ++i)
+        LOG_INFO << "thread " << t << " line " << i << " abcdefghijklmnopqrstuvwxyz";
+    });
+  }
+  for (std::thread& worker : workers)
+    worker.join();
+  double seconds = static_cast<double>(Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch()) /
+                   Timestamp::kMicroSecondsPerSecond;
+  log.stop();
+
+  AsyncLogging::Stats s = log.stats();
+  long total = static_cast<long>(threads) * lines;
+  printf("policy %s, limit %zu MB/thread, %zu MB total: %ld lines in %.3f s (%.1f ns/line)\n", policyName, limitMb,
+         totalLimitMb, total, seconds, seconds * 1e9 / static_cast<double>(total));
+  printf("dropped %lu messages (%lu bytes), %lu chunk allocations, %lu chunks still buffered, %lu producer blocks\n",
+         static_cast<unsigned long>(s.droppedMessages), static_cast<unsigned long>(s.droppedBytes),
+         static_cast<unsigned long>(s.chunkAllocations), static_cast<unsigned long>(s.bufferChunks),
+         static_cast<unsigned long>(s.producerBlocks));
+  printf("%lu writes, avg %.1f us, max %lu us\n", static_cast<unsigned long>(s.writes),
+         s.writes ? static_cast<double>(s.writeMicros) / static_cast<double>(s.writes) : 0.0,
+         static_cast<unsigned long>(s.maxWriteMicros));
+}
@@ -0,0 +1,62 @@
+#include "LogFile.h"
+#include "MonoTimestamp.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+// LogFile滚动时的停顿：./test25 [总MB] [滚动大小MB]
+// 按AsyncLogging后端的方式每次写4MB，统计每次append的耗时，滚动的那几次单独列出。
+// 文件写到 /tmp/test25.*.log，设置 LOG_FILE_WRITE=direct 对比绕过stdio的写法
+int main(int argc, char* argv[])
+{
+  int totalMb = argc > 1 ? atoi(argv[1]) : 256;
+  int rollMb = argc > 2 ? atoi(argv[2]) : 32;
+  const size_t kBlock = 4 * 1024 * 1024;
+
+  std::vector<char> block(kBlock);
+  for (size_t i = 0; i < kBlock; ++i)
+    block[i] = (i % 100 == 99) ? '\n' : static_cast<char>('a' + i % 26);
+
+  std::vector<int64_t> latencies;
+  std::vector<int64_t> rollLatencies;
+  MonoTimestamp start = MonoTimestamp::now();
+  {
+    LogFile file("/tmp/test25", static_cast<off_t>(rollMb) * 1024 * 1024);
+    off_t written = 0;
+    int blocks = totalMb / 4;
+    for (int i = 0; i < blocks; ++i)
+    {
+      // 超过rollsize之后的那次append会滚动
+      bool roll = written + static_cast<off_t>(kBlock) > static_cast<off_t>(rollMb) * 1024 * 1024;
+      MonoTimestamp begin = MonoTimestamp::now();
+      file.append(block.data(), static_cast<int>(kBlock));
+      int64_t us = MonoTimestamp::now().microSeconds() - begin.microSeconds();
+      latencies.push_back(us);
+      written = roll ? 0 : written + static_cast<off_t>(kBlock);
+      if (roll)
+        rollLatencies.push_back(us);
+      // 文件名精确到秒，同一秒内不会再次滚动
+      if (roll)
+        sleep(1);
+    }
+  }
+  double seconds = static_cast<double>(MonoTimestamp::now().microSeconds() - start.microSeconds()) / 1e6 -
+                   static_cast<double>(rollLatencies.size());
+
+  std::sort(latencies.begin(), latencies.end());
+  int64_t rollMax = rollLatencies.empty() ? 0 : *std::max_element(rollLatencies.begin(), rollLatencies.end());
+  int64_t rollSum = 0;
+  for (int64_t us : rollLatencies)
+    rollSum += us;
+  const char* mode = getenv("LOG_FILE_WRITE");
+  printf("write %s: %d MB in %.3f s (excluding sleeps), append p50 %ld us, p99 %ld us, max %ld us\n", mode ? mode : "stdio", totalMb,
+         seconds, static_cast<long>(latencies[latencies.size() / 2]),
+         static_cast<long>(latencies[latencies.size() * 99 / 100]), static_cast<long>(latencies.back()));
+  printf("%zu rolls: avg %.0f us, max %ld us\n", rollLatencies.size(),
+         rollLatencies.empty() ? 0.0 : static_cast<double>(rollSum) / static_cast<double>(rollLatencies.size()),
+         static_cast<long>(rollMax));
+}
@@ -0,0 +1,72 @@
+#include "FlightRecorder.h"
+#include "Logger.h"
+#include "Timestamp.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// 飞行记录器：./test26 [线程数] [每个线程的DEBUG日志条数]
+// 子进程常开DEBUG日志，只写进 /tmp/test26.flight（INFO以上照常输出到终端），最后LOG_FATAL终止；
+// 父进程等子进程结束后用 flightdecoder /tmp/test26.flight | tail 查看崩溃前的最后几条日志
+void nullOutput(const char*, int)
+{
+}
+
+// threads个线程各写lines条DEBUG日志，返回平均每条的耗时
+double runWorkers(int threads, int lines)
+{
+  Timestamp start = Timestamp::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t)
+  {
+    workers.emplace_back([t, lines] {
+      for (int i = 0; i < lines; ++i)
+        LOG_DEBUG << "thread " << t << " step " << i << " state=running";
+    });
+  }
+  for (std::thread& worker : workers)
+    worker.join();
+  double seconds = static_cast<double>(Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch()) /
+                   Timestamp::kMicroSecondsPerSecond;
+  return seconds * 1e9 / (static_cast<double>(threads) * lines);
+}
+
+int main(int argc, char* argv[])
+{
+  int threads = argc > 1 ? atoi(argv[1]) : 4;
+  int lines = argc > 2 ? atoi(argv[2]) : 1000000;
+
+  pid_t pid = ::fork();
+  if (pid == 0)
+  {
+    FlightRecorder recorder("/tmp/test26.flight", 16 * 1024 * 1024);
+    Logger::setLogLevel(Logger::DEBUG);
+    Logger::setFlightRecorder(&recorder, Logger::INFO);
+    LOG_INFO << "child " << ::getpid() << " started, flight recorder capacity " << recorder.capacity();
+
+    double recorderNs = runWorkers(threads, lines);
+    LOG_INFO << threads * lines << " DEBUG lines into the flight recorder, " << recorderNs << " ns/line";
+
+    // 对比：同样的日志交给一个什么也不做的输出函数，差值就是写飞行记录器的开销
+    Logger::setFlightRecorder(nullptr);
+    Logger::setOutput(nullOutput);
+    double nullNs = runWorkers(threads, lines);
+    Logger::setOutput([](const char* msg, int len) { fwrite(msg, 1, len, stdout); });
+    LOG_INFO << "same lines to a no-op output: " << nullNs << " ns/line";
+
+    Logger::setFlightRecorder(&recorder, Logger::INFO);
+    LOG_DEBUG << "last words before the crash";
+    LOG_FATAL << "simulated fatal error";
+  }
+
+  int status = 0;
+  ::waitpid(pid, &status, 0);
+  if (WIFSIGNALED(status))
+    printf("child killed by signal %d (%s)\n", WTERMSIG(status), strsignal(WTERMSIG(status)));
+  printf("decode: flightdecoder /tmp/test26.flight | tail\n");
+}
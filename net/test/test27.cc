@@ -0,0 +1,218 @@
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "Callbacks.h"
+#include "TcpConnection.h"
+#include "Buffer.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+// MSG_ZEROCOPY发送：./test27 [消息个数] [每条消息的字节数]
+// 服务端打开零拷贝，用send(std::move(msg))发出若干条大消息，同一个loop中的客户端收下并逐字节校验；
+// 等客户端收齐、并且服务端的完成通知全部到达（zeroCopyPendingBytes归零）之后打印统计退出。
+// 回环地址上内核会退化为拷贝发送，zeroCopyCopiedCount应当不为0，但完成通知照常上报。
+// 第二部分：客户端（另一个线程里的阻塞socket）先不读，零拷贝数据堵在服务端的发送队列里，这时客户端关闭写方向，
+// 服务端销毁连接；连接对象（fd和slice）要一直活到客户端读完、完成通知全部到达为止，客户端最后读到EOF
+const int kPort = 9983;
+const int kLingerPort = 9984;
+int g_messages = 64;
+size_t g_messageSize = 1024 * 1024;
+
+EventLoop* g_loop;
+TcpConnectionPtr g_serverConn;
+size_t g_received = 0;
+size_t g_maxPending = 0;
+bool g_highWater = false;
+bool g_corrupt = false;
+
+char expectedByte(size_t offset)
+{
+  return static_cast<char>('a' + offset % 26);
+}
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (!conn->connected())
+    return;
+  g_serverConn = conn;
+  conn->enableZeroCopy(64 * 1024);
+  // 高水位设为两条消息：排队的和等完成通知的一起计算
+  conn->setHighWaterMarkCallback([](const TcpConnectionPtr&, size_t len) { g_highWater = true; },
+                                 2 * g_messageSize);
+  size_t offset = 0;
+  for (int i = 0; i < g_messages; ++i)
+  {
+    std::string message(g_messageSize, '\0');
+    for (size_t j = 0; j < g_messageSize; ++j)
+      message[j] = expectedByte(offset + j);
+    offset += g_messageSize;
+    conn->send(std::move(message));
+    if (conn->zeroCopyPendingBytes() > g_maxPending)
+      g_maxPending = conn->zeroCopyPendingBytes();
+  }
+}
+
+void onClientMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  const char* data = buf->peek();
+  for (size_t i = 0; i < buf->readableBytes(); ++i)
+  {
+    if (data[i] != expectedByte(g_received + i))
+      g_corrupt = true;
+  }
+  g_received += buf->readableBytes();
+  buf->retrieveAll();
+}
+
+bool testSend()
+{
+  const size_t total = static_cast<size_t>(g_messages) * g_messageSize;
+
+  EventLoop loop;
+  g_loop = &loop;
+  InetAddress listenAddr(kPort, "127.0.0.1");
+  TcpServer server(&loop, listenAddr);
+  server.setConnectionCallback(onServerConnection);
+  server.setMessageCallback([](const TcpConnectionPtr&, Buffer* buf, Timestamp) { buf->retrieveAll(); });
+  server.start();
+
+  TcpClient client(&loop, listenAddr, "ZeroCopyClient");
+  client.setConnectionCallback([](const TcpConnectionPtr&) {});
+  client.setMessageCallback(onClientMessage);
+  client.connect();
+
+  int ticks = 0;
+  bool ok = false;
+  loop.runEvery(0.01, [&] {
+    ++ticks;
+    if (g_serverConn && g_serverConn->zeroCopyPendingBytes() > g_maxPending)
+      g_maxPending = g_serverConn->zeroCopyPendingBytes();
+    bool done = g_received == total && g_serverConn && g_serverConn->zeroCopyPendingBytes() == 0;
+    if (done || g_corrupt || ticks > 1000)
+    {
+      ok = done && !g_corrupt;
+      loop.quit();
+    }
+  });
+  loop.loop();
+
+  printf("received %zu / %zu bytes, content %s\n", g_received, total, g_corrupt ? "CORRUPT" : "ok");
+  if (g_serverConn)
+    printf("zero-copy pending %zu bytes (max seen %zu), copied fallbacks %lu, high water %s\n",
+           g_serverConn->zeroCopyPendingBytes(), g_maxPending,
+           static_cast<unsigned long>(g_serverConn->zeroCopyCopiedCount()), g_highWater ? "hit" : "not hit");
+  g_serverConn.reset();
+  return ok;
+}
+
+std::weak_ptr<TcpConnection> g_lingerConn;
+std::atomic<bool> g_startReading(false);
+std::atomic<bool> g_clientDone(false);
+bool g_aliveAfterClose = false;
+
+void onLingerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    g_lingerConn = conn;
+    conn->enableZeroCopy(64 * 1024);
+    size_t offset = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+      std::string message(g_messageSize, '\0');
+      for (size_t j = 0; j < g_messageSize; ++j)
+        message[j] = expectedByte(offset + j);
+      offset += g_messageSize;
+      conn->send(std::move(message));
+    }
+    return;
+  }
+  // connectDestroyed之后稍等一下，连接应当还被零拷贝的等待持有着，然后让客户端开始读
+  g_loop->runAfter(0.2, [] {
+    TcpConnectionPtr conn = g_lingerConn.lock();
+    g_aliveAfterClose = conn && conn->zeroCopyPendingBytes() > 0;
+    g_startReading = true;
+  });
+}
+
+bool testCloseWhilePending()
+{
+  EventLoop loop;
+  g_loop = &loop;
+  InetAddress listenAddr(kLingerPort, "127.0.0.1");
+  TcpServer server(&loop, listenAddr);
+  server.setConnectionCallback(onLingerConnection);
+  server.setMessageCallback([](const TcpConnectionPtr&, Buffer* buf, Timestamp) { buf->retrieveAll(); });
+  server.start();
+
+  size_t received = 0;
+  bool corrupt = false;
+  bool eof = false;
+  std::thread client([&] {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int rcvbuf = 64 * 1024;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kLingerPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof addr) == 0)
+    {
+      // 不读，等服务端把发送队列堆满之后关闭写方向
+      ::usleep(300 * 1000);
+      ::shutdown(fd, SHUT_WR);
+      while (!g_startReading)
+        ::usleep(10 * 1000);
+      char buf[64 * 1024];
+      ssize_t n;
+      while ((n = ::read(fd, buf, sizeof buf)) > 0)
+      {
+        for (ssize_t i = 0; i < n; ++i)
+        {
+          if (buf[i] != expectedByte(received + static_cast<size_t>(i)))
+            corrupt = true;
+        }
+        received += static_cast<size_t>(n);
+      }
+      eof = n == 0;
+    }
+    ::close(fd);
+    g_clientDone = true;
+  });
+
+  int ticks = 0;
+  loop.runEvery(0.01, [&] {
+    // 客户端读完之后完成通知到达，连接随之析构
+    if ((g_clientDone && g_lingerConn.expired()) || ++ticks > 1000)
+      loop.quit();
+  });
+  loop.loop();
+  client.join();
+
+  bool ok = g_aliveAfterClose && g_lingerConn.expired() && received > 0 && eof && !corrupt;
+  printf("close while pending: connection kept %s, client read %zu bytes then %s, content %s, released %s\n",
+         g_aliveAfterClose ? "yes" : "no", received, eof ? "EOF" : "error", corrupt ? "CORRUPT" : "ok",
+         g_lingerConn.expired() ? "yes" : "no");
+  return ok;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc > 1)
+    g_messages = atoi(argv[1]);
+  if (argc > 2)
+    g_messageSize = static_cast<size_t>(atoi(argv[2]));
+
+  bool ok = testSend();
+  ok = testCloseWhilePending() && ok;
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
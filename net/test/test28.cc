@@ -0,0 +1,152 @@
+#include "EventLoop.h"
+#include "MpscQueue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// 多生产者压MpscQueue：./test28 [生产者线程数] [每个线程的Functor数]
+// 第一部分：N个线程同时queueInLoop，loop线程在doPendingFunctors的drain中检查每个(生产者, 序号)
+//          恰好执行一次、并且同一个生产者的Functor按入队顺序执行；
+// 第二部分：直接用MpscQueue<uint64_t>，消费线程一边drain一边和生产者并发，检查同样的性质；
+// 第三部分：先push一百五十万个再一次drain，积压超过节点池第一页的容量也不能抛异常
+int g_producers = 4;
+int g_perProducer = 200000;
+
+EventLoop* g_loop;
+std::vector<int64_t> g_next;  // 每个生产者下一个期望的序号，只在loop线程访问
+int64_t g_executed = 0;
+bool g_failed = false;
+
+void onFunctor(int producer, int64_t seq)
+{
+  if (seq != g_next[producer])
+  {
+    if (!g_failed)
+      printf("loop: producer %d expect %lld got %lld\n", producer,
+             static_cast<long long>(g_next[producer]), static_cast<long long>(seq));
+    g_failed = true;
+  }
+  g_next[producer] = seq + 1;
+  ++g_executed;
+}
+
+bool testLoopDrain()
+{
+  EventLoop loop;
+  g_loop = &loop;
+  g_next.assign(g_producers, 0);
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < g_producers; ++p)
+  {
+    threads.emplace_back([p] {
+      for (int64_t seq = 0; seq < g_perProducer; ++seq)
+        g_loop->queueInLoop([p, seq] { onFunctor(p, seq); });
+    });
+  }
+  // 生产者全部结束后再入队一个检查结果的Functor，它一定排在所有生产者的Functor之后
+  std::thread waiter([&threads] {
+    for (auto& t : threads)
+      t.join();
+    g_loop->queueInLoop([] { g_loop->quit(); });
+  });
+  loop.loop();
+  waiter.join();
+
+  int64_t expected = static_cast<int64_t>(g_producers) * g_perProducer;
+  for (int p = 0; p < g_producers; ++p)
+  {
+    if (g_next[p] != g_perProducer)
+      g_failed = true;
+  }
+  EventLoop::Stats stats = loop.stats();
+  printf("loop drain: executed %lld of %lld, wakeup writes %llu, saved %llu\n",
+         static_cast<long long>(g_executed), static_cast<long long>(expected),
+         static_cast<unsigned long long>(stats.wakeupWrites), static_cast<unsigned long long>(stats.wakeupsSaved));
+  return !g_failed && g_executed == expected;
+}
+
+bool testQueue()
+{
+  MpscQueue<uint64_t> queue;
+  std::atomic<int> running(g_producers);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < g_producers; ++p)
+  {
+    threads.emplace_back([&queue, &running, p] {
+      for (uint64_t seq = 0; seq < static_cast<uint64_t>(g_perProducer); ++seq)
+        queue.push(static_cast<uint64_t>(p) << 32 | seq);
+      running.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  // 当前线程就是唯一的消费者
+  std::vector<uint64_t> next(g_producers, 0);
+  uint64_t received = 0;
+  uint64_t drains = 0;
+  bool failed = false;
+  auto consume = [&](uint64_t& value) {
+    int p = static_cast<int>(value >> 32);
+    uint64_t seq = value & 0xffffffff;
+    if (p >= g_producers || seq != next[p])
+    {
+      if (!failed)
+        printf("queue: value %llx out of order\n", static_cast<unsigned long long>(value));
+      failed = true;
+      return;
+    }
+    next[p] = seq + 1;
+    ++received;
+  };
+  while (running.load(std::memory_order_acquire) > 0)
+  {
+    if (queue.drain(consume) > 0)
+      ++drains;
+    else
+      std::this_thread::yield();
+  }
+  for (auto& t : threads)
+    t.join();
+  queue.drain(consume);
+
+  uint64_t expected = static_cast<uint64_t>(g_producers) * g_perProducer;
+  printf("queue: received %llu of %llu in %llu drains, empty %d\n",
+         static_cast<unsigned long long>(received), static_cast<unsigned long long>(expected),
+         static_cast<unsigned long long>(drains), queue.empty());
+  return !failed && received == expected && queue.empty();
+}
+
+bool testBacklog()
+{
+  const uint64_t kCount = 1500000;
+  MpscQueue<uint64_t> queue;
+  for (uint64_t i = 0; i < kCount; ++i)
+    queue.push(i);
+  uint64_t next = 0;
+  bool failed = false;
+  size_t drained = queue.drain([&](uint64_t& value) {
+    if (value != next)
+      failed = true;
+    next = value + 1;
+  });
+  printf("backlog: drained %zu of %llu, empty %d\n", drained, static_cast<unsigned long long>(kCount),
+         queue.empty());
+  return !failed && drained == kCount && queue.empty();
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc > 1)
+    g_producers = atoi(argv[1]);
+  if (argc > 2)
+    g_perProducer = atoi(argv[2]);
+
+  bool ok = testLoopDrain();
+  ok = testQueue() && ok;
+  ok = testBacklog() && ok;
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,253 @@
+#include "InlineFunction.h"
+#include "ObjectPool.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// InlineFunction的内部存储/堆两条路径和ObjectPool的空闲栈、代数：./test29
+// 用计数对象检查每个被捕获的对象恰好析构一次；多个线程并发create/destroy，检查同一个槽位不会同时发给两个对象
+int g_failures = 0;
+
+#define CHECK(cond)                                                 \
+  do                                                                \
+  {                                                                 \
+    if (!(cond))                                                    \
+    {                                                               \
+      printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      ++g_failures;                                                 \
+    }                                                               \
+  } while (0)
+
+// 记录存活个数的捕获对象，Size控制lambda的大小
+std::atomic<int> g_alive(0);
+
+template <size_t Size>
+struct Tracked
+{
+  Tracked() { ++g_alive; }
+  Tracked(const Tracked&) { ++g_alive; }
+  Tracked(Tracked&&) noexcept { ++g_alive; }
+  ~Tracked() { --g_alive; }
+  char pad[Size] = {};
+};
+
+// 移动构造可能抛异常，即使很小也要放到堆上
+struct ThrowingMove
+{
+  ThrowingMove() { ++g_alive; }
+  ThrowingMove(const ThrowingMove&) { ++g_alive; }
+  ThrowingMove(ThrowingMove&&) { ++g_alive; }
+  ~ThrowingMove() { --g_alive; }
+};
+
+using Func = InlineFunction<int(int), 64>;
+
+template <typename Captured>
+void testPath(bool expectInline)
+{
+  {
+    Captured captured;
+    auto lambda = [captured](int x) { return x + static_cast<int>(sizeof captured); };
+    CHECK(Func::isInline<decltype(lambda)>() == expectInline);
+
+    Func f(std::move(lambda));
+    CHECK(f);
+    CHECK(f(1) == 1 + static_cast<int>(sizeof(Captured)));
+
+    // 移动构造：源变空，目标可以调用
+    Func g(std::move(f));
+    CHECK(!f);
+    CHECK(g && g(2) == 2 + static_cast<int>(sizeof(Captured)));
+
+    // 移动赋值给一个已经持有对象的InlineFunction，旧对象要被析构
+    Func h([captured](int x) { return -x; });
+    h = std::move(g);
+    CHECK(!g);
+    CHECK(h(3) == 3 + static_cast<int>(sizeof(Captured)));
+
+    // 自赋值不改变内容
+    Func& alias = h;
+    h = std::move(alias);
+    CHECK(h && h(4) == 4 + static_cast<int>(sizeof(Captured)));
+
+    h = nullptr;
+    CHECK(!h);
+  }
+  CHECK(g_alive.load() == 0);
+}
+
+void testInlineFunction()
+{
+  testPath<Tracked<8>>(true);
+  testPath<Tracked<64>>(true);
+  testPath<Tracked<65>>(false);
+  testPath<Tracked<256>>(false);
+  testPath<ThrowingMove>(false);
+
+  // mutable lambda：状态保存在InlineFunction内部，移动之后继续累加
+  Func counter([n = 0](int x) mutable { return n += x; });
+  CHECK(counter(1) == 1);
+  CHECK(counter(2) == 3);
+  Func moved(std::move(counter));
+  CHECK(moved(3) == 6);
+
+  // 只能移动的捕获
+  auto ptr = std::make_unique<int>(42);
+  Func owner([p = std::move(ptr)](int x) { return *p + x; });
+  CHECK(owner(1) == 43);
+
+  // 默认构造和nullptr构造都是空的
+  Func empty;
+  Func null(nullptr);
+  CHECK(!empty && !null);
+  empty = std::move(owner);
+  CHECK(empty(0) == 42 && !owner);
+
+  // 一个vector里混放两种路径，扩容时逐个移动
+  {
+    std::vector<Func> funcs;
+    for (int i = 0; i < 100; ++i)
+    {
+      if (i % 2 == 0)
+        funcs.emplace_back([t = Tracked<16>(), i](int x) { return x + i; });
+      else
+        funcs.emplace_back([t = Tracked<128>(), i](int x) { return x - i; });
+    }
+    CHECK(g_alive.load() == 100);
+    int sum = 0;
+    for (int i = 0; i < 100; ++i)
+      sum += funcs[i](0);
+    CHECK(sum == -50);
+  }
+  CHECK(g_alive.load() == 0);
+  printf("InlineFunction: %s\n", g_failures == 0 ? "ok" : "failed");
+}
+
+struct Item
+{
+  explicit Item(int o) : owner(o) {}
+  std::atomic<int> owner;
+  std::string value;
+};
+
+void testObjectPoolSingle()
+{
+  ObjectPool<Item> pool;
+  Item* a = pool.create(1);
+  CHECK(pool.capacity() == ObjectPool<Item>::kChunkSize);
+  uint32_t gen = pool.generation(a);
+  a->value = "hello";
+  pool.destroy(a);
+  CHECK(pool.generation(a) == gen + 1);
+
+  // 空闲栈后进先出：刚释放的槽位马上被复用，代数不再等于旧句柄记下的值
+  Item* b = pool.create(2);
+  CHECK(b == a);
+  CHECK(b->owner.load() == 2 && b->value.empty());
+  CHECK(pool.generation(b) != gen);
+  pool.destroy(b);
+
+  // 超过一块之后扩容，所有对象地址互不相同
+  std::vector<Item*> items;
+  for (uint32_t i = 0; i < 3 * ObjectPool<Item>::kChunkSize + 1; ++i)
+    items.push_back(pool.create(static_cast<int>(i)));
+  CHECK(pool.capacity() == 4 * ObjectPool<Item>::kChunkSize);
+  for (size_t i = 0; i < items.size(); ++i)
+    CHECK(items[i]->owner.load() == static_cast<int>(i));
+  for (Item* item : items)
+    pool.destroy(item);
+  // 全部归还之后再取同样多个不会再扩容
+  items.clear();
+  for (uint32_t i = 0; i < 4 * ObjectPool<Item>::kChunkSize; ++i)
+    items.push_back(pool.create(0));
+  CHECK(pool.capacity() == 4 * ObjectPool<Item>::kChunkSize);
+  for (Item* item : items)
+    pool.destroy(item);
+}
+
+// 多个线程反复create/destroy：归还时owner必须还是自己、代数也没有变，
+// 否则说明同一个槽位被同时发给了两个线程（空闲栈的ABA）
+void testObjectPoolThreads()
+{
+  const int kThreads = 4;
+  const int kRounds = 200000;
+  const int kHold = 8;
+  ObjectPool<Item> pool;
+  std::atomic<int> conflicts(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t)
+  {
+    threads.emplace_back([&pool, &conflicts, t] {
+      Item* held[kHold] = {};
+      uint32_t gens[kHold] = {};
+      for (int i = 0; i < kRounds; ++i)
+      {
+        int k = i % kHold;
+        if (held[k] != nullptr)
+        {
+          if (held[k]->owner.exchange(-1) != t || pool.generation(held[k]) != gens[k])
+            ++conflicts;
+          pool.destroy(held[k]);
+        }
+        held[k] = pool.create(t);
+        gens[k] = pool.generation(held[k]);
+      }
+      for (int k = 0; k < kHold; ++k)
+      {
+        if (held[k]->owner.exchange(-1) != t)
+          ++conflicts;
+        pool.destroy(held[k]);
+      }
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+  CHECK(conflicts.load() == 0);
+  // 同时存活的对象最多kThreads * kHold个，一块就够了
+  CHECK(pool.capacity() == ObjectPool<Item>::kChunkSize);
+  printf("ObjectPool: %d threads x %d rounds, capacity %zu, conflicts %d\n",
+         kThreads, kRounds, pool.capacity(), conflicts.load());
+}
+
+// 同时存活超过一百万个对象：槽位表要跨过第一页继续扩容，而不是抛bad_alloc
+void testObjectPoolLarge()
+{
+  const uint32_t kCount = 1200000;
+  ObjectPool<Item> pool;
+  std::vector<Item*> items;
+  items.reserve(kCount);
+  for (uint32_t i = 0; i < kCount; ++i)
+    items.push_back(pool.create(static_cast<int>(i)));
+  size_t capacity = pool.capacity();
+  CHECK(capacity >= kCount && capacity < kCount + ObjectPool<Item>::kChunkSize);
+  int wrong = 0;
+  for (uint32_t i = 0; i < kCount; ++i)
+  {
+    if (items[i]->owner.load() != static_cast<int>(i))
+      ++wrong;
+  }
+  CHECK(wrong == 0);
+  for (Item* item : items)
+    pool.destroy(item);
+  // 归还之后再取一遍不会扩容
+  for (uint32_t i = 0; i < kCount; ++i)
+    items[i] = pool.create(0);
+  CHECK(pool.capacity() == capacity);
+  for (Item* item : items)
+    pool.destroy(item);
+  printf("ObjectPool: %u live objects, capacity %zu\n", kCount, capacity);
+}
+
+int main()
+{
+  testInlineFunction();
+  testObjectPoolSingle();
+  testObjectPoolThreads();
+  testObjectPoolLarge();
+  printf("%s\n", g_failures == 0 ? "PASS" : "FAIL");
+  return g_failures == 0 ? 0 : 1;
+}
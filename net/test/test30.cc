@@ -0,0 +1,148 @@
+#include "Logger.h"
+#include "Timestamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <random>
+#include <thread>
+#include <vector>
+
+// 日志时间格式化和localtime_r逐秒对比：./test30 [时区...]
+// formatLogTime缓存时区偏移（一小时，或者到下一次切换为止），自己用公历算法换算日期，这里检查夏令时切换前后、
+// 半小时/45分钟偏移的时区、时间倒退和大跨度跳跃时都和localtime_r的结果一致。
+// 缓存是线程局部的，每个时区在新线程里测试，互不影响
+const char* kDefaultZones[] = {
+    "UTC",
+    "America/New_York",
+    "Europe/London",
+    "Europe/Dublin",      // 冬令时是负的夏令时偏移
+    "Australia/Lord_Howe",// 夏令时只差30分钟
+    "America/St_Johns",   // -3:30，2011年以前在本地00:01切换
+    "Pacific/Chatham",    // +12:45
+    "Asia/Kolkata",
+    "Asia/Tehran",
+    "Africa/Casablanca",  // 斋月期间暂停夏令时，一年切换多次
+};
+
+const time_t kBegin = 31536000;   // 1971-01-01
+const time_t kEnd = 2208988800;   // 2040-01-01
+
+struct Result
+{
+  long checked = 0;
+  long mismatches = 0;
+  int transitions = 0;
+};
+
+// localtime_r得到的期望值；编译器不知道各字段的取值范围，size要按int的最大宽度留够（64字节）
+void expected(time_t seconds, int microseconds, char* out, size_t size)
+{
+  struct tm tm_time;
+  localtime_r(&seconds, &tm_time);
+  snprintf(out, size, "%4d/%02d/%02d %02d:%02d:%02d.%06d ", tm_time.tm_year + 1900, tm_time.tm_mon + 1,
+           tm_time.tm_mday, tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec, microseconds);
+}
+
+void check(const char* zone, time_t seconds, int microseconds, Result* result)
+{
+  char got[detail::kLogTimeLength];
+  char want[64];
+  detail::formatLogTime(Timestamp(static_cast<int64_t>(seconds) * Timestamp::kMicroSecondsPerSecond + microseconds),
+                        got);
+  expected(seconds, microseconds, want, sizeof want);
+  ++result->checked;
+  if (memcmp(got, want, detail::kLogTimeLength) != 0)
+  {
+    if (result->mismatches < 5)
+      printf("%s: %ld got \"%.27s\" want \"%s\"\n", zone, static_cast<long>(seconds), got, want);
+    ++result->mismatches;
+  }
+}
+
+// 找出[kBegin, kEnd)中所有的偏移变化点（精确到秒）
+std::vector<time_t> findTransitions()
+{
+  std::vector<time_t> transitions;
+  struct tm tm_time;
+  localtime_r(&kBegin, &tm_time);
+  long offset = tm_time.tm_gmtoff;
+  // 按15分钟扫描，找到变化后二分到秒；两次切换相隔不会短于15分钟
+  for (time_t t = kBegin + 900; t < kEnd; t += 900)
+  {
+    localtime_r(&t, &tm_time);
+    if (tm_time.tm_gmtoff == offset)
+      continue;
+    time_t lo = t - 900, hi = t;
+    while (hi - lo > 1)
+    {
+      time_t mid = lo + (hi - lo) / 2;
+      localtime_r(&mid, &tm_time);
+      if (tm_time.tm_gmtoff == offset)
+        lo = mid;
+      else
+        hi = mid;
+    }
+    transitions.push_back(hi);
+    localtime_r(&t, &tm_time);
+    offset = tm_time.tm_gmtoff;
+  }
+  return transitions;
+}
+
+void testZone(const char* zone, Result* result)
+{
+  std::vector<time_t> transitions = findTransitions();
+  result->transitions = static_cast<int>(transitions.size());
+
+  // 按时间顺序逐秒走过每个切换点前后10分钟，再按37秒的步长走前后3小时
+  for (time_t transition : transitions)
+  {
+    for (time_t t = transition - 600; t < transition + 600; ++t)
+      check(zone, t, static_cast<int>(t % 1000) * 1000, result);
+    for (time_t t = transition - 3 * 3600; t < transition + 3 * 3600; t += 37)
+      check(zone, t, 999999, result);
+  }
+
+  // 随机游走：大多是几秒以内的前进，偶尔大跨度跳跃或者倒退
+  std::mt19937_64 rng(42);
+  time_t t = 1700000000;
+  for (int i = 0; i < 300000; ++i)
+  {
+    unsigned r = static_cast<unsigned>(rng() % 100);
+    if (r < 90)
+      t += static_cast<time_t>(rng() % 3);
+    else if (r < 97)
+      t += static_cast<time_t>(rng() % (400L * 86400));
+    else
+      t -= static_cast<time_t>(rng() % (100L * 86400));
+    if (t < kBegin || t >= kEnd)
+      t = kBegin + static_cast<time_t>(rng() % static_cast<uint64_t>(kEnd - kBegin));
+    check(zone, t, static_cast<int>(rng() % 1000000), result);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  std::vector<const char*> zones;
+  for (int i = 1; i < argc; ++i)
+    zones.push_back(argv[i]);
+  if (zones.empty())
+    zones.assign(std::begin(kDefaultZones), std::end(kDefaultZones));
+
+  long mismatches = 0;
+  for (const char* zone : zones)
+  {
+    setenv("TZ", zone, 1);
+    tzset();
+    Result result;
+    std::thread thread(testZone, zone, &result);
+    thread.join();
+    printf("%-20s %4d transitions, %8ld checked, %ld mismatches\n", zone, result.transitions, result.checked,
+           result.mismatches);
+    mismatches += result.mismatches;
+  }
+  printf("%s\n", mismatches == 0 ? "PASS" : "FAIL");
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+#include "EventLoop.h"
+#include "TimerId.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// 同时存活超过一百万个定时器：./test31 [每个线程的定时器个数]
+// loop线程和另一个线程各添加N个一小时后到期的定时器（跨线程的经过queueInLoop），再加一批10ms后到期的短定时器，
+// 检查runAfter不抛异常、短定时器全部按时触发、长定时器一个也没有触发，最后全部取消
+int g_perThread = 600000;
+const int kShortTimers = 1000;
+
+EventLoop* g_loop;
+int g_shortFired = 0;
+int g_longFired = 0;
+
+void addTimers(std::vector<TimerId>* ids, bool* threw)
+{
+  try
+  {
+    for (int i = 0; i < g_perThread; ++i)
+      ids->push_back(g_loop->runAfter(3600 + i % 1000, [] { ++g_longFired; }));
+  }
+  catch (const std::exception& e)
+  {
+    printf("runAfter threw after %zu timers: %s\n", ids->size(), e.what());
+    *threw = true;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc > 1)
+    g_perThread = atoi(argv[1]);
+
+  EventLoop loop;
+  g_loop = &loop;
+  std::vector<TimerId> local, remote;
+  local.reserve(g_perThread);
+  remote.reserve(g_perThread);
+  bool localThrew = false, remoteThrew = false;
+
+  addTimers(&local, &localThrew);
+  std::thread producer(addTimers, &remote, &remoteThrew);
+  for (int i = 0; i < kShortTimers; ++i)
+    loop.runAfter(0.01 + i * 1e-5, [] { ++g_shortFired; });
+
+  // 跨线程添加完之后再排一个检查，1秒后取消全部长定时器并退出
+  std::thread waiter([&producer] {
+    producer.join();
+    g_loop->queueInLoop([] {
+      g_loop->runAfter(1.0, [] { g_loop->quit(); });
+    });
+  });
+  loop.loop();
+  waiter.join();
+
+  for (const TimerId& id : local)
+    loop.cancel(id);
+  for (const TimerId& id : remote)
+    loop.cancel(id);
+
+  EventLoop::Stats stats = loop.stats();
+  printf("live timers %zu, short fired %d/%d, long fired %d, timersFired %lu\n", local.size() + remote.size(),
+         g_shortFired, kShortTimers, g_longFired, static_cast<unsigned long>(stats.timersFired));
+  bool ok = !localThrew && !remoteThrew && g_shortFired == kShortTimers && g_longFired == 0;
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
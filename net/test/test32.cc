@@ -0,0 +1,87 @@
+#include "AsyncLogging.h"
+#include "Logger.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <thread>
+
+// 一个线程写了一阵之后空闲，占着所有线程的缓冲总上限：./test32
+// 空闲线程在后端开始之前写满总上限（8MB，之后的日志被丢弃），等后端写完之后只是活着不再写日志；另一个线程接着写，
+// 分不到块时要能拿回空闲线程已经写完的块，kBlockProducer和kDropNewest都不应该丢日志。
+// kBlockProducer再等两个flushInterval，检查空闲线程多出来的块已经由后端还给总上限。日志写到 /tmp/test32.*.log
+AsyncLogging* g_asyncLog = nullptr;
+const int kTotalLimitMb = 8;
+const int kLines = 20000;
+
+void asyncOutput(const char* msg, int len)
+{
+  g_asyncLog->append(msg, len);
+}
+
+bool run(const char* name, AsyncLogging::OverflowPolicy policy, bool waitIdle)
+{
+  const int kFlushInterval = 2;
+  AsyncLogging log("/tmp/test32", 500 * 1000 * 1000, kFlushInterval);
+  log.setBufferLimit(64 * 1024 * 1024, policy);
+  log.setTotalBufferLimit(kTotalLimitMb * 1024 * 1024);
+  g_asyncLog = &log;
+
+  bool idleDone = false;
+  bool quit = false;
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::thread idle([&] {
+    for (int i = 0; i < 200000; ++i)
+      LOG_INFO << "burst line " << i << " abcdefghijklmnopqrstuvwxyz";
+    std::unique_lock<std::mutex> lock(mutex);
+    idleDone = true;
+    cond.notify_all();
+    cond.wait(lock, [&] { return quit; });
+  });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [&] { return idleDone; });
+  }
+  AsyncLogging::Stats burst = log.stats();
+  log.start();
+  // 等后端写完空闲线程的块，但是还不到一个flushInterval，后端还不会主动释放它们
+  usleep(300 * 1000);
+
+  std::thread writer([] {
+    for (int i = 0; i < kLines; ++i)
+      LOG_INFO << "writer line " << i << " abcdefghijklmnopqrstuvwxyz";
+  });
+  writer.join();
+  AsyncLogging::Stats written = log.stats();
+  uint64_t dropped = written.droppedMessages - burst.droppedMessages;
+
+  // 空闲线程超过一个flushInterval没有写日志，它写完的块应当已经释放，只剩它自己的一块
+  // （写日志的线程已经退出，缓冲链被后端回收）
+  if (waitIdle)
+    sleep(2 * kFlushInterval + 1);
+  AsyncLogging::Stats after = log.stats();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    quit = true;
+  }
+  cond.notify_all();
+  idle.join();
+  log.stop();
+
+  bool ok = dropped == 0 && (!waitIdle || after.bufferChunks == 1);
+  printf("%-6s burst held %lu chunks, writer dropped %lu of %d, %lu blocks, %lu chunks after idle: %s\n", name,
+         static_cast<unsigned long>(burst.bufferChunks), static_cast<unsigned long>(dropped), kLines,
+         static_cast<unsigned long>(written.producerBlocks), static_cast<unsigned long>(after.bufferChunks),
+         ok ? "ok" : "failed");
+  return ok;
+}
+
+int main()
+{
+  Logger::setOutput(asyncOutput);
+  bool ok = run("block", AsyncLogging::kBlockProducer, true);
+  ok = run("newest", AsyncLogging::kDropNewest, false) && ok;
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
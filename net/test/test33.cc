@@ -0,0 +1,111 @@
+#include "TcpServer.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "Callbacks.h"
+#include "TcpConnection.h"
+#include "Buffer.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+// io_uring模式下发送失败：./test33 [轮数]
+// 服务端不停地给一个不读数据的客户端发1MB的消息，sendmsg一直挂在ring上；客户端用SO_LINGER 0关闭，对端重置。
+// sendmsg以错误完成后连接要被关闭：连接回调恰好收到一次断开，连接对象随后析构，之后不再提交新的sendmsg。
+// 没有设置 POLLER_BACKEND 时默认用io_uring；内核不支持io_uring时退回就绪模式，检查同样成立
+const int kPort = 9985;
+int g_rounds = 5;
+
+EventLoop* g_loop;
+std::weak_ptr<TcpConnection> g_conn;
+int g_up = 0;
+int g_down = 0;
+bool g_ioUring = false;
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+  if (!conn->connected())
+  {
+    ++g_down;
+    return;
+  }
+  ++g_up;
+  g_conn = conn;
+  g_ioUring = conn->ioUringMode();
+}
+
+// 每10ms补一条消息，保证客户端重置时总有sendmsg在内核中
+void feed()
+{
+  if (TcpConnectionPtr conn = g_conn.lock())
+  {
+    if (conn->connected())
+      conn->send(std::string(1024 * 1024, 'x'));
+  }
+}
+
+bool runRound(int round)
+{
+  int up = g_up, down = g_down;
+  std::thread client([] {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int rcvbuf = 64 * 1024;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof addr) == 0)
+    {
+      // 不读，让服务端的发送队列堆满
+      ::usleep(200 * 1000);
+      struct linger lg = {1, 0};
+      ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof lg);
+    }
+    ::close(fd);
+  });
+
+  int ticks = 0;
+  bool closed = false;
+  TimerId timer = g_loop->runEvery(0.01, [&] {
+    feed();
+    closed = g_down > down && g_conn.expired();
+    if (closed || ++ticks > 300)
+      g_loop->quit();
+  });
+  g_loop->loop();
+  g_loop->cancel(timer);
+  client.join();
+
+  bool ok = closed && g_up == up + 1 && g_down == down + 1;
+  printf("round %d: io_uring=%d, up %d, down %d, released %s: %s\n", round, g_ioUring, g_up - up, g_down - down,
+         g_conn.expired() ? "yes" : "no", ok ? "ok" : "failed");
+  return ok;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc > 1)
+    g_rounds = atoi(argv[1]);
+  ::setenv("POLLER_BACKEND", "io_uring", 0);
+
+  EventLoop loop;
+  g_loop = &loop;
+  InetAddress listenAddr(kPort, "127.0.0.1");
+  TcpServer server(&loop, listenAddr);
+  server.setConnectionCallback(onConnection);
+  server.setMessageCallback([](const TcpConnectionPtr&, Buffer* buf, Timestamp) { buf->retrieveAll(); });
+  server.setIoUringMode(true);
+  server.start();
+
+  bool ok = true;
+  for (int i = 0; i < g_rounds; ++i)
+    ok = runRound(i) && ok;
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}